@@ -0,0 +1,227 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-aging.c
+ * \brief Wait bound benchmark of the aging under overload.
+ *
+ * The tool overloads the scheduler on a virtual clock, where a callback
+ * spends its work by advancing one tick itself:
+ *
+ * - two storms of priority 0 and 1, that post themselves again at the end
+ *   of each callback, so that they always take the whole CPU;
+ * - the housekeeping of priority 2 and 3, two cyclic events.
+ *
+ * The run is done twice: without aging, where the storm of priority 0
+ * starves all the other groups, and with the aging threshold of all the
+ * groups (-a). The report gives for each run and group the dispatched
+ * events, the promoted ones and the mean and longest wait from
+ * \ref WETS_getWaitStatistics, with the bound: the threshold, plus the
+ * callback that is running and one promoted event of each other group,
+ * each one a tick of work. A group that never ran has waited all the run.
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_AGING=1 \
+ *        [-DWETS_USE_...] -o wets-aging \
+ *        tools/wets-aging.c wets-*.c -lpthread -lrt
+ *     ./wets-aging [-d duration] [-a threshold] [-o report]
+ *
+ * -d is the length of each run in milli-second of the virtual clock
+ * (default 60000), -a the aging threshold in milli-second (default
+ * WETS_AGING_THRESHOLD_ms). The report is a list of "key value" lines,
+ * like the one of wets-replay, that can be saved with -o; the times are in
+ * milli-second. The exit code is 1 when a wait is over the bound.
+ */
+
+#include "wets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if (WETS_USE_AGING == 0) || (WETS_USE_WAIT_STATISTICS == 0)
+#error "WETS: the aging benchmark requires WETS_USE_AGING and WETS_USE_WAIT_STATISTICS"
+#endif
+
+#if (WETS_MAX_PRIORITY_LEVEL < 4)
+#error "WETS: the aging benchmark requires at least 4 priority levels"
+#endif
+
+/*!
+ * The default length of each run in milli-second.
+ */
+#define WETS_AGING_DURATION_ms                   60000u
+
+/*!
+ * The periods of the cyclic events of priority 2 and 3, in milli-second.
+ */
+#define WETS_AGING_CYCLE_2_ms                    50u
+#define WETS_AGING_CYCLE_3_ms                    100u
+
+/*!
+ * The function spends the work of a callback: one tick of the virtual
+ * clock.
+ */
+static uint32_t workCallback (uint32_t status)
+{
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+
+    WETS_timerIsrCallback(NULL);
+    return status & ~(1ul << bit);
+}
+
+static uint32_t storm0Callback (uint32_t status)
+{
+    status = workCallback(status);
+    WETS_addEvent(storm0Callback,0,1ul);
+    return status;
+}
+
+static uint32_t storm1Callback (uint32_t status)
+{
+    status = workCallback(status);
+    WETS_addEvent(storm1Callback,1,1ul);
+    return status;
+}
+
+/*!
+ * The function runs the overload, with an aging threshold.
+ *
+ * \return TRUE when the waits are within the bound, FALSE otherwise.
+ */
+static bool runOverload (FILE* out,
+                         const char* name,
+                         uint32_t duration,
+                         uint32_t threshold)
+{
+    bool bounded = TRUE;
+
+    WETS_init();
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        WETS_setAgingThreshold(i,threshold);
+    }
+
+    WETS_addEvent(storm0Callback,0,1ul);
+    WETS_addEvent(storm1Callback,1,1ul);
+    WETS_addCyclicEvent(workCallback,2,1ul,WETS_AGING_CYCLE_2_ms);
+    WETS_addCyclicEvent(workCallback,3,1ul,WETS_AGING_CYCLE_3_ms);
+    WETS_clearWaitStatistics();
+
+    uint32_t start = WETS_getCurrentTime();
+    while ((WETS_getCurrentTime() - start) < duration)
+    {
+        // The clock goes on by itself only when the scheduler is idle
+        if (WETS_poll(1,WETS_NO_TIMEOUT) != 0)
+        {
+            WETS_timerIsrCallback(NULL);
+        }
+    }
+    uint32_t elapsed = WETS_getCurrentTime() - start;
+    uint32_t bound = threshold + (WETS_MAX_PRIORITY_LEVEL * WETS_ISR_PERIOD_ms);
+
+    if (threshold > 0)
+    {
+        fprintf(out,"%s_bound %lu\n",name,(unsigned long)bound);
+    }
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        WETS_WaitStatistics_t statistics;
+        WETS_getWaitStatistics(i,&statistics);
+
+        uint32_t max = (statistics.count > 0) ? statistics.max : elapsed;
+        fprintf(out,"%s_p%u_dispatched %lu\n",name,i,(unsigned long)statistics.count);
+        fprintf(out,"%s_p%u_promoted %lu\n",name,i,(unsigned long)statistics.promoted);
+        fprintf(out,"%s_p%u_wait_mean %.1f\n",name,i,
+                (statistics.count > 0) ?
+                ((double)statistics.total / statistics.count) : (double)elapsed);
+        fprintf(out,"%s_p%u_wait_max %lu\n",name,i,(unsigned long)max);
+
+        if ((threshold > 0) && (max > bound))
+        {
+            bounded = FALSE;
+        }
+    }
+    return bounded;
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-d duration] [-a threshold] [-o report]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long duration = WETS_AGING_DURATION_ms;
+    unsigned long threshold = WETS_AGING_THRESHOLD_ms;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"d:a:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            duration = strtoul(optarg,NULL,0);
+            break;
+        case 'a':
+            threshold = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((duration == 0) || (threshold == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"tick_ms %u\n",(unsigned int)WETS_ISR_PERIOD_ms);
+    fprintf(out,"threshold %lu\n",threshold);
+
+    runOverload(out,"strict",duration,0);
+    bool bounded = runOverload(out,"aging",duration,threshold);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return bounded ? 0 : 1;
+}
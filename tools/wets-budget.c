@@ -0,0 +1,262 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-budget.c
+ * \brief Isolation benchmark of the CPU budgets.
+ *
+ * The tool runs three groups on a virtual clock, where a callback spends
+ * its work by advancing the ticks itself:
+ *
+ * - the control task, a cyclic event of priority 0 that works for one tick
+ *   every 10 ticks;
+ * - a telemetry storm of priority 2, that posts itself again at the end of
+ *   each callback, so that the group is always ready;
+ * - the housekeeping of priority 3, always ready like the storm.
+ *
+ * The run is done twice: without any budget, where the storm starves the
+ * housekeeping, and with the budget of the storm (-b, -p). The report gives
+ * for each run the CPU share of the groups, the worst jitter of the
+ * control task and the longest gap between two housekeeping callbacks.
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_CPU_BUDGET=1 \
+ *        [-DWETS_USE_...] -o wets-budget \
+ *        tools/wets-budget.c wets-*.c -lpthread -lrt
+ *     ./wets-budget [-d duration] [-b budget] [-p period] [-o report]
+ *
+ * -d is the length of each run in milli-second of the virtual clock
+ * (default 60000), -b and -p the budget of the storm and its period in
+ * milli-second (default 20 over 100). The report is a list of "key value"
+ * lines, like the one of wets-replay, that can be saved with -o; the times
+ * are in milli-second.
+ */
+
+#include "wets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if (WETS_USE_CPU_BUDGET == 0)
+#error "WETS: the budget benchmark requires WETS_USE_CPU_BUDGET"
+#endif
+
+#if (WETS_MAX_PRIORITY_LEVEL < 4)
+#error "WETS: the budget benchmark requires at least 4 priority levels"
+#endif
+
+/*!
+ * The default length of each run in milli-second.
+ */
+#define WETS_BUDGET_DURATION_ms                  60000u
+
+/*!
+ * The default budget of the storm and its period, in milli-second.
+ */
+#define WETS_BUDGET_BUDGET_ms                    20u
+#define WETS_BUDGET_PERIOD_ms                    100u
+
+/*!
+ * The period of the control task, in ticks.
+ */
+#define WETS_BUDGET_CONTROL_TICKS                10u
+
+#define WETS_BUDGET_CONTROL                      0u
+#define WETS_BUDGET_STORM                        2u
+#define WETS_BUDGET_HOUSEKEEPING                 3u
+
+/*!
+ * The time spent by the callbacks of each group.
+ */
+static uint32_t mWork[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The start of the last callback and the worst gap between two callbacks,
+ * of the control task and of the housekeeping.
+ */
+static uint32_t mLastStart[WETS_MAX_PRIORITY_LEVEL];
+static uint32_t mWorstGap[WETS_MAX_PRIORITY_LEVEL];
+static bool mStarted[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The function spends the work of a callback: one tick of the virtual
+ * clock.
+ */
+static void work (uint8_t priority)
+{
+    uint32_t now = WETS_getCurrentTime();
+
+    if (mStarted[priority] && ((now - mLastStart[priority]) > mWorstGap[priority]))
+    {
+        mWorstGap[priority] = now - mLastStart[priority];
+    }
+    mStarted[priority]   = TRUE;
+    mLastStart[priority] = now;
+
+    WETS_timerIsrCallback(NULL);
+    mWork[priority] += WETS_ISR_PERIOD_ms;
+}
+
+static uint32_t controlCallback (uint32_t status)
+{
+    work(WETS_BUDGET_CONTROL);
+    return status & ~1ul;
+}
+
+static uint32_t stormCallback (uint32_t status)
+{
+    work(WETS_BUDGET_STORM);
+    WETS_addEvent(stormCallback,WETS_BUDGET_STORM,1ul);
+    return status & ~1ul;
+}
+
+static uint32_t housekeepingCallback (uint32_t status)
+{
+    work(WETS_BUDGET_HOUSEKEEPING);
+    WETS_addEvent(housekeepingCallback,WETS_BUDGET_HOUSEKEEPING,1ul);
+    return status & ~1ul;
+}
+
+/*!
+ * The function runs the groups for a duration, with a budget of the storm.
+ */
+static void runGroups (FILE* out,
+                       const char* name,
+                       uint32_t duration,
+                       uint32_t budget,
+                       uint32_t period)
+{
+    WETS_init();
+    memset(mWork,0,sizeof(mWork));
+    memset(mWorstGap,0,sizeof(mWorstGap));
+    memset(mStarted,0,sizeof(mStarted));
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        WETS_setPriorityBudget(i,0,0);
+    }
+    WETS_setPriorityBudget(WETS_BUDGET_STORM,budget,period);
+
+    WETS_addCyclicEvent(controlCallback,WETS_BUDGET_CONTROL,1ul,
+                        WETS_BUDGET_CONTROL_TICKS * WETS_ISR_PERIOD_ms);
+    WETS_addEvent(stormCallback,WETS_BUDGET_STORM,1ul);
+    WETS_addEvent(housekeepingCallback,WETS_BUDGET_HOUSEKEEPING,1ul);
+
+    uint32_t start = WETS_getCurrentTime();
+    while ((WETS_getCurrentTime() - start) < duration)
+    {
+        // The clock goes on by itself only when the scheduler is idle
+        if (WETS_poll(1,WETS_NO_TIMEOUT) != 0)
+        {
+            WETS_timerIsrCallback(NULL);
+        }
+    }
+    uint32_t elapsed = WETS_getCurrentTime() - start;
+
+    WETS_Budget_t usage;
+    WETS_getPriorityBudget(WETS_BUDGET_STORM,&usage);
+
+    fprintf(out,"%s_share_control %.1f\n",name,
+            100.0 * mWork[WETS_BUDGET_CONTROL] / elapsed);
+    fprintf(out,"%s_share_storm %.1f\n",name,
+            100.0 * mWork[WETS_BUDGET_STORM] / elapsed);
+    fprintf(out,"%s_share_housekeeping %.1f\n",name,
+            100.0 * mWork[WETS_BUDGET_HOUSEKEEPING] / elapsed);
+    fprintf(out,"%s_control_jitter_max %lu\n",name,
+            (unsigned long)(mWorstGap[WETS_BUDGET_CONTROL] -
+                            (WETS_BUDGET_CONTROL_TICKS * WETS_ISR_PERIOD_ms)));
+    // A group that never ran has waited all the run
+    fprintf(out,"%s_housekeeping_gap_max %lu\n",name,
+            (unsigned long)(mStarted[WETS_BUDGET_HOUSEKEEPING] ?
+                            mWorstGap[WETS_BUDGET_HOUSEKEEPING] : elapsed));
+    fprintf(out,"%s_storm_throttled %lu\n",name,(unsigned long)usage.throttled);
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-d duration] [-b budget] [-p period] [-o report]\n",
+            name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long duration = WETS_BUDGET_DURATION_ms;
+    unsigned long budget = WETS_BUDGET_BUDGET_ms;
+    unsigned long period = WETS_BUDGET_PERIOD_ms;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"d:b:p:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            duration = strtoul(optarg,NULL,0);
+            break;
+        case 'b':
+            budget = strtoul(optarg,NULL,0);
+            break;
+        case 'p':
+            period = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((duration == 0) || (budget == 0) || (budget > period))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"tick_ms %u\n",(unsigned int)WETS_ISR_PERIOD_ms);
+    fprintf(out,"storm_budget %lu\n",budget);
+    fprintf(out,"storm_period %lu\n",period);
+
+    runGroups(out,"unlimited",duration,0,0);
+    runGroups(out,"budget",duration,budget,period);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-burst.c
+ * \brief Burst throughput benchmark of the dispatcher.
+ *
+ * The tool sets a burst of ready events into the least important group,
+ * then measures the time that \ref WETS_poll takes to dispatch all of
+ * them. The callbacks only clear their event, so the time is the cost of
+ * the dispatcher: the scan of the groups, the critical sections and the
+ * status word for each event, or a single pass with the drain mode.
+ *
+ * Build it twice, with and without the drain mode, and compare the two
+ * reports:
+ *
+ *     cc -O2 -I. -I<libohiboard> [-DWETS_USE_DRAIN_MODE=1] \
+ *        [-DWETS_USE_...] -o wets-burst \
+ *        tools/wets-burst.c wets-*.c -lpthread -lrt
+ *     ./wets-burst [-n repeats] [-o report] [burst...]
+ *
+ * Each burst is a number of events, from 1 to 32, the default is 1, 4, 8,
+ * 16 and 32. -n is the number of bursts for each size (default 10000).
+ * The report is a list of "key value" lines, like the one of wets-replay,
+ * that can be saved with -o; the times are in nano-second per event.
+ */
+
+#include "wets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*!
+ * The default number of bursts for each size.
+ */
+#define WETS_BURST_REPEATS                       10000u
+
+/*!
+ * The maximum size of a burst: the events of a group.
+ */
+#define WETS_BURST_MAX                           32u
+
+/*!
+ * The group of the bursts: the last one, so that each scan from the
+ * highest priority crosses all the groups.
+ */
+#define WETS_BURST_PRIORITY                      (WETS_MAX_PRIORITY_LEVEL - 1)
+
+static uint32_t mDispatched = 0;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The callback of all the events: the dispatched event is the highest bit
+ * of the status, like the scheduler does.
+ */
+static uint32_t burstCallback (uint32_t status)
+{
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+
+    mDispatched++;
+    return status & ~(1ul << bit);
+}
+
+/*!
+ * The function measures the bursts of a size.
+ *
+ * \return TRUE when all the events were dispatched, FALSE otherwise.
+ */
+static bool runBurst (FILE* out, unsigned int size, unsigned long repeats)
+{
+    uint64_t total = 0, best = UINT64_MAX, worst = 0;
+
+    WETS_init();
+    mDispatched = 0;
+
+    for (unsigned long r = 0; r < repeats; ++r)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            WETS_addEvent(burstCallback,WETS_BURST_PRIORITY,1ul << i);
+        }
+
+        uint64_t start = getTime();
+        while (WETS_poll(UINT16_MAX,WETS_NO_TIMEOUT) == 0)
+        {
+        }
+        uint64_t elapsed = getTime() - start;
+
+        total += elapsed;
+        best   = (elapsed < best) ? elapsed : best;
+        worst  = (elapsed > worst) ? elapsed : worst;
+    }
+
+    if (mDispatched != (uint32_t)(size * repeats))
+    {
+        fprintf(stderr,"wets-burst: %u events dispatched instead of %lu\n",
+                mDispatched,size * repeats);
+        return FALSE;
+    }
+
+    fprintf(out,"burst_%u_mean %.1f\n",size,
+            (double)total / (double)(repeats * size));
+    fprintf(out,"burst_%u_min %.1f\n",size,(double)best / size);
+    fprintf(out,"burst_%u_max %.1f\n",size,(double)worst / size);
+    return TRUE;
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-n repeats] [-o report] [burst...]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    static const unsigned int defaultBursts[] = { 1, 4, 8, 16, 32 };
+    const char* report = NULL;
+    unsigned long repeats = WETS_BURST_REPEATS;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            repeats = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (repeats == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    unsigned int runs = (optind < argc) ? (unsigned int)(argc - optind) : 5u;
+    for (unsigned int r = 0; (optind < argc) && (r < runs); ++r)
+    {
+        unsigned long size = strtoul(argv[optind + r],NULL,0);
+        if ((size == 0) || (size > WETS_BURST_MAX))
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"drain_mode %u\n",(unsigned int)WETS_USE_DRAIN_MODE);
+
+    for (unsigned int r = 0; r < runs; ++r)
+    {
+        unsigned int size = defaultBursts[r];
+        if (optind < argc)
+        {
+            size = (unsigned int)strtoul(argv[optind + r],NULL,0);
+        }
+        if (!runBurst(out,size,repeats))
+        {
+            return 2;
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,412 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-bus.c
+ * \brief Throughput and latency benchmark of the inter-process bus.
+ *
+ * The tool forks a receiver process and sends it events, first through the
+ * bus of \ref WETS_IpcBus, where the receiver runs \ref WETS_loop, then
+ * through a pipe, where the receiver blocks on read(), like the processes
+ * that signal each other without the bus. Each message carries a priority,
+ * an event and a 64 bit payload in both cases.
+ *
+ * The throughput is measured by sending a stream of messages as fast as
+ * the receiver takes them: the payload is the sequence number, and the
+ * stream ends when the receiver sees the last one. With the bus, the
+ * pending messages of the same event are merged by the tables, so the
+ * dispatches are fewer than the messages. The latency is measured by
+ * sending one message at a time, with the receiver idle: the payload is
+ * the time of the send, and the receiver takes the time of the callback.
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_IO_SOURCES=1 -DWETS_USE_IPC=1 \
+ *        -DWETS_USE_EVENT_PAYLOAD=1 [-DWETS_USE_...] -o wets-bus \
+ *        tools/wets-bus.c wets-*.c -lpthread -lrt
+ *     ./wets-bus [-m messages] [-n samples] [-o report]
+ *
+ * -m is the length of the stream (default 1000000), -n the number of
+ * messages for the latency (default 2000). The report is a list of
+ * "key value" lines, like the one of wets-replay, that can be saved with
+ * -o; the latency is in micro-second.
+ */
+
+#include "wets.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (WETS_USE_IPC == 0) || (WETS_USE_EVENT_PAYLOAD == 0)
+#error "WETS: the bus benchmark requires WETS_USE_IPC and WETS_USE_EVENT_PAYLOAD"
+#endif
+
+/*!
+ * The default length of the stream.
+ */
+#define WETS_BUS_MESSAGES                        1000000ul
+
+/*!
+ * The default number of messages for the latency.
+ */
+#define WETS_BUS_SAMPLES                         2000u
+
+/*!
+ * The idle time between two messages of the latency, in micro-second.
+ */
+#define WETS_BUS_IDLE_us                         500u
+
+#define WETS_BUS_NAME                            "/wets-bus-bench"
+
+/*!
+ * The events of the benchmark, all of priority 0.
+ */
+#define WETS_BUS_STREAM                          0x00000001ul
+#define WETS_BUS_PING                            0x00000002ul
+#define WETS_BUS_STOP                            0x00000004ul
+
+/*!
+ * The message of the pipe: the same content of a cell of the bus.
+ */
+typedef struct _WETS_BusMessage
+{
+    uint64_t payload;
+    uint32_t event;
+    uint8_t  priority;
+} WETS_BusMessage_t;
+
+/*!
+ * The results of the receiver, shared with the sender.
+ */
+typedef struct _WETS_BusShared
+{
+    atomic_uint_fast64_t last;
+    atomic_uint_fast64_t dispatched;
+    atomic_uint_fast64_t pings;
+    atomic_uint_fast64_t latency;
+} WETS_BusShared_t;
+
+static WETS_BusShared_t* mShared = NULL;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The function handles a message on the receiver side, for both the bus
+ * and the pipe.
+ */
+static void receive (uint32_t event, uint64_t payload)
+{
+    uint64_t now = getTime();
+
+    atomic_fetch_add(&mShared->dispatched,1);
+    if (event == WETS_BUS_STREAM)
+    {
+        atomic_store(&mShared->last,payload);
+    }
+    else if (event == WETS_BUS_PING)
+    {
+        atomic_store(&mShared->latency,now - payload);
+        atomic_fetch_add(&mShared->pings,1);
+    }
+}
+
+static uint32_t streamCallback (uint32_t status)
+{
+    receive(WETS_BUS_STREAM,WETS_getEventPayload(0,WETS_BUS_STREAM));
+    return status & ~WETS_BUS_STREAM;
+}
+
+static uint32_t pingCallback (uint32_t status)
+{
+    receive(WETS_BUS_PING,WETS_getEventPayload(0,WETS_BUS_PING));
+    return status & ~WETS_BUS_PING;
+}
+
+static uint32_t stopCallback (uint32_t status)
+{
+    WETS_closeIpcBus();
+    _exit(0);
+    return status & ~WETS_BUS_STOP;
+}
+
+/*!
+ * The receiver of the bus: the scheduler of the other process.
+ */
+static void runBusReceiver (void)
+{
+    WETS_init();
+    if (WETS_openIpcBus(WETS_BUS_NAME) != WETS_ERROR_SUCCESS)
+    {
+        _exit(2);
+    }
+    WETS_addIpcEvent(streamCallback,0,WETS_BUS_STREAM);
+    WETS_addIpcEvent(pingCallback,0,WETS_BUS_PING);
+    WETS_addIpcEvent(stopCallback,0,WETS_BUS_STOP);
+    WETS_loop();
+}
+
+/*!
+ * The receiver of the pipe.
+ */
+static void runPipeReceiver (int fd)
+{
+    WETS_BusMessage_t message;
+
+    while (read(fd,&message,sizeof(message)) == (ssize_t)sizeof(message))
+    {
+        if (message.event == WETS_BUS_STOP)
+        {
+            _exit(0);
+        }
+        receive(message.event,message.payload);
+    }
+    _exit(2);
+}
+
+/*!
+ * The sender side of a transport: the bus peer or the pipe.
+ */
+typedef struct _WETS_BusSender
+{
+    WETS_IpcPeer_t peer;
+    int            fd;
+    bool           isPipe;
+} WETS_BusSender_t;
+
+static void sendMessage (WETS_BusSender_t* sender, uint32_t event, uint64_t payload)
+{
+    if (sender->isPipe)
+    {
+        WETS_BusMessage_t message = { payload, event, 0 };
+        if (write(sender->fd,&message,sizeof(message)) != (ssize_t)sizeof(message))
+        {
+            perror("wets-bus");
+            exit(2);
+        }
+        return;
+    }
+
+    for (;;)
+    {
+        WETS_Error_t err = WETS_sendIpcEvent(&sender->peer,0,event,payload);
+        if (err == WETS_ERROR_SUCCESS)
+        {
+            return;
+        }
+        if (err != WETS_ERROR_IPC_QUEUE_FULL)
+        {
+            fprintf(stderr,"wets-bus: send failed (%x)\n",(unsigned int)err);
+            exit(2);
+        }
+        sched_yield();
+    }
+}
+
+static int compareSamples (const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*!
+ * The function measures a transport, with the receiver already started.
+ */
+static void runSender (FILE* out,
+                       const char* name,
+                       WETS_BusSender_t* sender,
+                       unsigned long messages,
+                       unsigned int samples)
+{
+    uint64_t* latency = calloc(samples,sizeof(uint64_t));
+    if (latency == NULL)
+    {
+        perror("wets-bus");
+        exit(2);
+    }
+
+    // The stream
+    atomic_store(&mShared->last,0);
+    atomic_store(&mShared->dispatched,0);
+    uint64_t start = getTime();
+    for (unsigned long i = 1; i <= messages; ++i)
+    {
+        sendMessage(sender,WETS_BUS_STREAM,i);
+    }
+    while (atomic_load(&mShared->last) != messages)
+    {
+        sched_yield();
+    }
+    double elapsed = (double)(getTime() - start) / 1e9;
+
+    fprintf(out,"%s_throughput %.0f\n",name,(double)messages / elapsed);
+    fprintf(out,"%s_dispatched %llu\n",name,
+            (unsigned long long)atomic_load(&mShared->dispatched));
+
+    // One message at a time, with the receiver idle
+    atomic_store(&mShared->pings,0);
+    for (unsigned int i = 0; i < samples; ++i)
+    {
+        usleep(WETS_BUS_IDLE_us);
+        sendMessage(sender,WETS_BUS_PING,getTime());
+        while (atomic_load(&mShared->pings) != (i + 1))
+        {
+            sched_yield();
+        }
+        latency[i] = atomic_load(&mShared->latency);
+    }
+    qsort(latency,samples,sizeof(uint64_t),compareSamples);
+
+    fprintf(out,"%s_latency_median %.1f\n",name,latency[samples / 2] / 1e3);
+    fprintf(out,"%s_latency_p99 %.1f\n",name,latency[(samples * 99u) / 100u] / 1e3);
+    fprintf(out,"%s_latency_max %.1f\n",name,latency[samples - 1] / 1e3);
+
+    sendMessage(sender,WETS_BUS_STOP,0);
+    free(latency);
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-m messages] [-n samples] [-o report]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long messages = WETS_BUS_MESSAGES;
+    unsigned long samples = WETS_BUS_SAMPLES;
+    WETS_BusSender_t sender;
+    int status = 0;
+    pid_t pid;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"m:n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            messages = strtoul(optarg,NULL,0);
+            break;
+        case 'n':
+            samples = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((messages == 0) || (samples == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    mShared = mmap(NULL,sizeof(WETS_BusShared_t),PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS,-1,0);
+    if (mShared == MAP_FAILED)
+    {
+        perror("wets-bus");
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fflush(out);
+
+    // The bus
+    pid = fork();
+    if (pid == 0)
+    {
+        runBusReceiver();
+    }
+    memset(&sender,0,sizeof(sender));
+    // Wait the receiver to open its bus
+    for (unsigned int i = 0;
+         WETS_connectIpcBus(WETS_BUS_NAME,&sender.peer) != WETS_ERROR_SUCCESS;
+         ++i)
+    {
+        if ((i >= 1000u) || (waitpid(pid,&status,WNOHANG) != 0))
+        {
+            fprintf(stderr,"wets-bus: the bus can't be opened\n");
+            kill(pid,SIGKILL);
+            return 2;
+        }
+        usleep(1000);
+    }
+    runSender(out,"bus",&sender,messages,(unsigned int)samples);
+    waitpid(pid,&status,0);
+    WETS_disconnectIpcBus(&sender.peer);
+
+    // The pipe
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("wets-bus");
+        return 2;
+    }
+    fflush(out);
+    pid = fork();
+    if (pid == 0)
+    {
+        close(fds[1]);
+        runPipeReceiver(fds[0]);
+    }
+    close(fds[0]);
+    memset(&sender,0,sizeof(sender));
+    sender.fd     = fds[1];
+    sender.isPipe = TRUE;
+    runSender(out,"pipe",&sender,messages,(unsigned int)samples);
+    waitpid(pid,&status,0);
+    close(fds[1]);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-contention.c
+ * \brief Contention benchmark of the priority threads.
+ *
+ * The tool runs the preemptive port of \ref WETS_PriorityThread on the host,
+ * with a producer thread for each priority group that posts its events as
+ * fast as it can, while the group threads dispatch them and the tick thread
+ * updates the time base. The callbacks only count the dispatches.
+ *
+ * The cache misses and the L1 data cache read misses of the process are
+ * counted in user space with perf_event_open(), for all the threads of the
+ * run. When the counters are not available (perf_event_paranoid, a virtual
+ * machine without PMU...) only the throughput is reported.
+ *
+ * The tool is meant to be built twice, with and without
+ * WETS_USE_CACHE_ALIGNMENT, to compare the false sharing between the
+ * producers, the dispatchers and the tick:
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_PRIORITY_THREADS=1 \
+ *        [-DWETS_USE_CACHE_ALIGNMENT=1] [-DWETS_USE_...] -o wets-contention \
+ *        tools/wets-contention.c wets-*.c -lpthread -lrt
+ *     ./wets-contention [-d duration] [-e events] [-o report]
+ *
+ * -d is the length of the run in milli-second (default 1000), -e the number
+ * of events posted by each producer (default 8, up to 32). The report is a
+ * list of "key value" lines, like the one of wets-replay, that can be saved
+ * with -o.
+ */
+
+#include "wets.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#if (WETS_USE_PRIORITY_THREADS == 0)
+#error "WETS: the contention benchmark requires WETS_USE_PRIORITY_THREADS"
+#endif
+
+#if (WETS_MAX_PRIORITY_LEVEL > 8)
+#error "WETS: the contention benchmark supports up to 8 priority levels"
+#endif
+
+/*!
+ * The default length of the run in milli-second.
+ */
+#define WETS_CONTENTION_DURATION_ms              1000u
+
+/*!
+ * The default number of events of each producer.
+ */
+#define WETS_CONTENTION_EVENTS                   8u
+
+/*!
+ * The dispatches of each group, written only by the thread of the group and
+ * read after its end, each one on its own line so that the benchmark doesn't
+ * add its own false sharing.
+ */
+static WETS_CACHE_PADDED(uint64_t) mDispatched[8];
+
+/*!
+ * The posts accepted for each group, written only by its producer.
+ */
+static WETS_CACHE_PADDED(uint64_t) mPosted[8];
+
+static atomic_bool mRunning = true;
+
+static unsigned int mEvents = WETS_CONTENTION_EVENTS;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The callback of all the events of a priority: the dispatched event is the
+ * highest bit of the status, like the scheduler does.
+ */
+static uint32_t dispatch (uint8_t priority, uint32_t status)
+{
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+
+    mDispatched[priority].value++;
+    return status & ~(1ul << bit);
+}
+
+#define WETS_CONTENTION_CALLBACK(n)                                            \
+    static uint32_t contentionCallback##n (uint32_t status)                    \
+    {                                                                          \
+        return dispatch(n,status);                                             \
+    }
+
+WETS_CONTENTION_CALLBACK(0)
+WETS_CONTENTION_CALLBACK(1)
+WETS_CONTENTION_CALLBACK(2)
+WETS_CONTENTION_CALLBACK(3)
+WETS_CONTENTION_CALLBACK(4)
+WETS_CONTENTION_CALLBACK(5)
+WETS_CONTENTION_CALLBACK(6)
+WETS_CONTENTION_CALLBACK(7)
+
+static const pEventCallback mCallbacks[8] =
+{
+    contentionCallback0, contentionCallback1,
+    contentionCallback2, contentionCallback3,
+    contentionCallback4, contentionCallback5,
+    contentionCallback6, contentionCallback7,
+};
+
+/*!
+ * The producer of a priority group: it posts its events in turn, an event
+ * still pending is refused by the scheduler and is not counted.
+ */
+static void* produce (void* arg)
+{
+    uint8_t priority = (uint8_t)(uintptr_t)arg;
+    uint64_t posted = 0;
+    unsigned int i = 0;
+
+    while (atomic_load_explicit(&mRunning,memory_order_relaxed))
+    {
+        uint32_t event = 1ul << (i % mEvents);
+        WETS_Error_t err = WETS_addEvent(mCallbacks[priority],priority,event);
+        if (err == WETS_ERROR_SUCCESS)
+        {
+            posted++;
+        }
+        i++;
+    }
+    mPosted[priority].value = posted;
+    return NULL;
+}
+
+/*!
+ * The function opens a hardware cache counter for the process, inherited by
+ * the threads created after it, in user space only.
+ *
+ * \return The file descriptor, or -1 when the counter is not available.
+ */
+static int openCounter (uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+}
+
+/*!
+ * The function reads a counter and closes it. The counts of the threads are
+ * added to the one of the process when they end, so it must be called after
+ * all the threads were joined.
+ *
+ * \return TRUE when the count is valid, FALSE otherwise.
+ */
+static bool closeCounter (int fd, uint64_t* count)
+{
+    bool valid = FALSE;
+
+    if (fd >= 0)
+    {
+        valid = (read(fd,count,sizeof(*count)) == (ssize_t)sizeof(*count));
+        close(fd);
+    }
+    return valid;
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-d duration] [-e events] [-o report]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long duration = WETS_CONTENTION_DURATION_ms;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"d:e:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            duration = strtoul(optarg,NULL,0);
+            break;
+        case 'e':
+            mEvents = (unsigned int)strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((duration == 0) || (mEvents == 0) || (mEvents > 32))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // The counters are opened first, to be inherited by all the threads
+    int cacheMisses = openCounter(PERF_TYPE_HARDWARE,
+                                  PERF_COUNT_HW_CACHE_MISSES);
+    int l1dMisses = openCounter(PERF_TYPE_HW_CACHE,
+                                PERF_COUNT_HW_CACHE_L1D |
+                                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if ((cacheMisses < 0) || (l1dMisses < 0))
+    {
+        fprintf(stderr,"wets-contention: cache counters not available (%s), "
+                       "only the throughput is reported\n",strerror(errno));
+    }
+
+    WETS_init();
+    WETS_Error_t err = WETS_startPriorityThreads();
+    if (err == WETS_ERROR_NO_REAL_TIME)
+    {
+        fprintf(stderr,"wets-contention: running without SCHED_FIFO\n");
+    }
+    else if (err != WETS_ERROR_SUCCESS)
+    {
+        fprintf(stderr,"wets-contention: the priority threads "
+                       "can't be started\n");
+        return 2;
+    }
+
+    pthread_t producers[WETS_MAX_PRIORITY_LEVEL];
+    uint64_t start = getTime();
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        if (pthread_create(&producers[i],NULL,produce,(void*)(uintptr_t)i) != 0)
+        {
+            perror("wets-contention");
+            return 2;
+        }
+    }
+
+    struct timespec sleep = { (time_t)(duration / 1000u),
+                              (long)(duration % 1000u) * 1000000l };
+    while (nanosleep(&sleep,&sleep) != 0)
+    {
+    }
+
+    atomic_store(&mRunning,false);
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        pthread_join(producers[i],NULL);
+    }
+    WETS_stopPriorityThreads();
+    double elapsed = (double)(getTime() - start) / 1e9;
+
+    uint64_t posted = 0, dispatched = 0;
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        posted += mPosted[i].value;
+        dispatched += mDispatched[i].value;
+    }
+
+    uint64_t cacheCount = 0, l1dCount = 0;
+    bool cacheValid = closeCounter(cacheMisses,&cacheCount);
+    bool l1dValid = closeCounter(l1dMisses,&l1dCount);
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+
+    fprintf(out,"cache_alignment %u\n",(unsigned int)WETS_USE_CACHE_ALIGNMENT);
+    fprintf(out,"producers %u\n",(unsigned int)WETS_MAX_PRIORITY_LEVEL);
+    fprintf(out,"posted %llu\n",(unsigned long long)posted);
+    fprintf(out,"dispatched %llu\n",(unsigned long long)dispatched);
+    fprintf(out,"throughput %.0f\n",
+            (elapsed > 0) ? ((double)dispatched / elapsed) : 0);
+    if (cacheValid)
+    {
+        fprintf(out,"cache_misses %llu\n",(unsigned long long)cacheCount);
+        fprintf(out,"cache_misses_per_dispatch %.2f\n",
+                (dispatched > 0) ?
+                ((double)cacheCount / (double)dispatched) : 0);
+    }
+    if (l1dValid)
+    {
+        fprintf(out,"l1d_misses %llu\n",(unsigned long long)l1dCount);
+        fprintf(out,"l1d_misses_per_dispatch %.2f\n",
+                (dispatched > 0) ?
+                ((double)l1dCount / (double)dispatched) : 0);
+    }
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
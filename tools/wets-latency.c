@@ -0,0 +1,268 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-latency.c
+ * \brief Preemption latency benchmark of the priority threads.
+ *
+ * The tool runs the preemptive port of \ref WETS_PriorityThread on the host,
+ * with a callback of the least important group that burns the CPU for a
+ * fixed time and posts itself again, so that the group is always busy.
+ * Meanwhile an event of priority 0 is posted at random intervals, and the
+ * time from its post to the start of its callback is measured. With the
+ * real-time priorities this latency doesn't depend on the length of the
+ * busy callback.
+ *
+ * The posts come from the main thread, that is raised above the group
+ * threads, otherwise the busy group would starve it on a single CPU.
+ *
+ * Build with the library, then run it as a user that can use SCHED_FIFO
+ * (CAP_SYS_NICE or RLIMIT_RTPRIO):
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_PRIORITY_THREADS=1 \
+ *        [-DWETS_USE_...] -o wets-latency \
+ *        tools/wets-latency.c wets-*.c -lpthread -lrt
+ *     ./wets-latency [-n samples] [-o report] [work...]
+ *
+ * Each work is the length in milli-second of the busy callback, the
+ * default is 1, 20 and 100. -n is the number of posts for each work
+ * (default 200). The report is a list of "key value" lines, like the one
+ * of wets-replay, that can be saved with -o; the latency is in
+ * micro-second.
+ */
+
+#include "wets.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (WETS_USE_PRIORITY_THREADS == 0)
+#error "WETS: the latency benchmark requires WETS_USE_PRIORITY_THREADS"
+#endif
+
+#if (WETS_MAX_PRIORITY_LEVEL < 2)
+#error "WETS: the latency benchmark requires at least 2 priority levels"
+#endif
+
+/*!
+ * The default number of posts for each work.
+ */
+#define WETS_LATENCY_SAMPLES                     200u
+
+/*!
+ * The group of the busy callback.
+ */
+#define WETS_LATENCY_BUSY_PRIORITY               (WETS_MAX_PRIORITY_LEVEL - 1u)
+
+/*!
+ * The time of the last post of the measured event.
+ */
+static atomic_ullong mPostedAt;
+
+/*!
+ * The latency of the last dispatch of the measured event, 0 until it is
+ * dispatched.
+ */
+static atomic_ullong mLatency;
+
+/*!
+ * The length of the busy callback in nano-second, 0 to stop it.
+ */
+static atomic_ullong mWork;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The callback of the measured event.
+ */
+static uint32_t measureCallback (uint32_t status)
+{
+    uint64_t now = getTime();
+    uint64_t posted = atomic_load(&mPostedAt);
+
+    atomic_store(&mLatency,(now > posted) ? (now - posted) : 1u);
+    return status & ~1ul;
+}
+
+/*!
+ * The callback of the busy group: it burns the CPU and posts itself again.
+ */
+static uint32_t busyCallback (uint32_t status)
+{
+    uint64_t work = atomic_load(&mWork);
+    uint64_t start = getTime();
+
+    while ((getTime() - start) < work)
+    {
+    }
+    if (work > 0)
+    {
+        WETS_addEvent(busyCallback,WETS_LATENCY_BUSY_PRIORITY,1ul);
+    }
+    return status & ~1ul;
+}
+
+static int compareLatencies (const void* a, const void* b)
+{
+    uint64_t la = *(const uint64_t*)a;
+    uint64_t lb = *(const uint64_t*)b;
+
+    return (la < lb) ? -1 : (la > lb);
+}
+
+static void sleepFor (uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (nanosleep(&ts,&ts) != 0)
+    {
+    }
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-n samples] [-o report] [work...]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    static const unsigned long defaultWorks[] = { 1, 20, 100 };
+    const char* report = NULL;
+    unsigned long samples = WETS_LATENCY_SAMPLES;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            samples = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (samples == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    unsigned int works = (optind < argc) ? (unsigned int)(argc - optind) : 3u;
+    uint64_t* latencies = malloc(samples * sizeof(uint64_t));
+    if (latencies == NULL)
+    {
+        perror("wets-latency");
+        return 2;
+    }
+
+    WETS_init();
+    WETS_Error_t err = WETS_startPriorityThreads();
+    if (err == WETS_ERROR_NO_REAL_TIME)
+    {
+        fprintf(stderr,"wets-latency: running without SCHED_FIFO, the latency "
+                       "depends on the time sharing of the kernel\n");
+    }
+    else if (err != WETS_ERROR_SUCCESS)
+    {
+        fprintf(stderr,"wets-latency: the priority threads can't be started\n");
+        return 2;
+    }
+    else
+    {
+        // The posts must preempt the busy group, also on a single CPU
+        struct sched_param param = { .sched_priority = WETS_THREAD_BASE_PRIORITY + WETS_MAX_PRIORITY_LEVEL + 1 };
+        pthread_setschedparam(pthread_self(),SCHED_FIFO,&param);
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"real_time %u\n",(err == WETS_ERROR_SUCCESS) ? 1u : 0u);
+
+    srand(1);
+    for (unsigned int w = 0; w < works; ++w)
+    {
+        unsigned long work = (optind < argc) ? strtoul(argv[optind + w],NULL,0) : defaultWorks[w];
+
+        atomic_store(&mWork,(unsigned long long)work * 1000000ull);
+        WETS_addEvent(busyCallback,WETS_LATENCY_BUSY_PRIORITY,1ul);
+
+        for (unsigned long i = 0; i < samples; ++i)
+        {
+            // From 0.5 to 2.5 ms, so that the posts fall anywhere into the
+            // busy callback
+            sleepFor(500000ull + (uint64_t)(rand() % 2000) * 1000ull);
+
+            atomic_store(&mLatency,0u);
+            atomic_store(&mPostedAt,getTime());
+            WETS_addEvent(measureCallback,0,1ul);
+            while (atomic_load(&mLatency) == 0)
+            {
+                sleepFor(50000ull);
+            }
+            latencies[i] = atomic_load(&mLatency);
+        }
+
+        // The busy callback ends at its next run
+        atomic_store(&mWork,0u);
+        sleepFor((uint64_t)(work + 1u) * 1000000ull);
+
+        qsort(latencies,samples,sizeof(uint64_t),compareLatencies);
+        fprintf(out,"latency_p50_%lums %llu\n",work,(unsigned long long)(latencies[(samples - 1) / 2] / 1000u));
+        fprintf(out,"latency_p99_%lums %llu\n",work,(unsigned long long)(latencies[((samples - 1) * 99) / 100] / 1000u));
+        fprintf(out,"latency_max_%lums %llu\n",work,(unsigned long long)(latencies[samples - 1] / 1000u));
+    }
+
+    WETS_stopPriorityThreads();
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    free(latencies);
+    return 0;
+}
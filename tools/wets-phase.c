@@ -0,0 +1,253 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-phase.c
+ * \brief Per-tick load benchmark of the cyclic phases.
+ *
+ * The tool adds a set of cyclic events with the same period, then runs the
+ * scheduler on a virtual clock, one tick at a time, and dispatches all the
+ * events expired on each tick. Each callback works for a fixed time on the
+ * real clock, and the dispatch latency is the time from the tick to the
+ * start of the callback.
+ *
+ * The run is done twice: with all the timers on the same phase, like when
+ * each one was armed one period after its registration at boot, and with
+ * the phases chosen by \ref WETS_addCyclicEvent. The report gives for each
+ * run the peak of \ref WETS_getCyclicLoad, the most callbacks of a tick,
+ * and the mean, the 99th percentile and the worst dispatch latency; the
+ * worst one includes the preemptions of the host.
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_CYCLIC_PHASE=1 \
+ *        [-DWETS_USE_...] -o wets-phase \
+ *        tools/wets-phase.c wets-*.c -lpthread -lrt
+ *     ./wets-phase [-t timers] [-c cycle] [-w work] [-d duration]
+ *                  [-o report]
+ *
+ * -t is the number of timers, from 1 to 32 (default 16), -c their period
+ * in milli-second (default 50), -w the work of a callback in micro-second
+ * (default 100) and -d the length of each run in ticks (default 2000).
+ * The report is a list of "key value" lines, like the one of wets-replay,
+ * that can be saved with -o; the latency is in micro-second.
+ */
+
+#include "wets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (WETS_USE_CYCLIC_PHASE == 0)
+#error "WETS: the phase benchmark requires WETS_USE_CYCLIC_PHASE"
+#endif
+
+#define WETS_PHASE_TIMERS                        16u
+#define WETS_PHASE_TIMERS_MAX                    32u
+#define WETS_PHASE_CYCLE_ms                      50u
+#define WETS_PHASE_WORK_us                       100u
+#define WETS_PHASE_DURATION                      2000u
+
+static uint64_t mWork = 0;
+static uint64_t mTickTime = 0;
+
+/*!
+ * The latency of the callbacks and the callbacks of the current tick.
+ */
+static uint64_t* mLatency = NULL;
+static uint64_t mLatencySum = 0;
+static uint32_t mDispatched = 0;
+static uint32_t mTickDispatched = 0;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The callback of all the timers: the dispatched event is the highest bit
+ * of the status, like the scheduler does.
+ */
+static uint32_t cyclicCallback (uint32_t status)
+{
+    uint64_t start = getTime();
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+
+    uint64_t latency = start - mTickTime;
+    mLatency[mDispatched] = latency;
+    mLatencySum += latency;
+    mDispatched++;
+    mTickDispatched++;
+
+    while ((getTime() - start) < mWork)
+    {
+    }
+    return status & ~(1ul << bit);
+}
+
+static int compareSamples (const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*!
+ * The function runs the timers, on the same phase or on the chosen ones.
+ */
+static void runTimers (FILE* out,
+                       const char* name,
+                       bool aligned,
+                       unsigned int timers,
+                       uint32_t cycle,
+                       unsigned long duration)
+{
+    WETS_CyclicLoad_t load;
+    uint32_t tickPeak = 0;
+
+    WETS_init();
+    mLatencySum = 0;
+    mDispatched = 0;
+
+    for (unsigned int i = 0; i < timers; ++i)
+    {
+        if (aligned)
+        {
+            WETS_addPhasedCyclicEvent(cyclicCallback,0,1ul << i,cycle,cycle);
+        }
+        else
+        {
+            WETS_addCyclicEvent(cyclicCallback,0,1ul << i,cycle);
+        }
+    }
+    WETS_clearCyclicLoad();
+
+    for (unsigned long t = 0; t < duration; ++t)
+    {
+        mTickDispatched = 0;
+        mTickTime = getTime();
+        WETS_timerIsrCallback(NULL);
+        while (WETS_poll(UINT16_MAX,WETS_NO_TIMEOUT) == 0)
+        {
+        }
+        tickPeak = (mTickDispatched > tickPeak) ? mTickDispatched : tickPeak;
+    }
+    WETS_getCyclicLoad(&load);
+    qsort(mLatency,mDispatched,sizeof(uint64_t),compareSamples);
+
+    fprintf(out,"%s_load_peak %u\n",name,(unsigned int)load.peak);
+    fprintf(out,"%s_tick_dispatched_max %lu\n",name,(unsigned long)tickPeak);
+    fprintf(out,"%s_dispatched %lu\n",name,(unsigned long)mDispatched);
+    fprintf(out,"%s_latency_mean %.1f\n",name,
+            (mDispatched > 0) ? ((double)mLatencySum / mDispatched / 1e3) : 0);
+    fprintf(out,"%s_latency_p99 %.1f\n",name,
+            (mDispatched > 0) ? (mLatency[(mDispatched * 99u) / 100u] / 1e3) : 0);
+    fprintf(out,"%s_latency_max %.1f\n",name,
+            (mDispatched > 0) ? (mLatency[mDispatched - 1] / 1e3) : 0);
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-t timers] [-c cycle] [-w work] [-d duration]"
+                   " [-o report]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long timers = WETS_PHASE_TIMERS;
+    unsigned long cycle = WETS_PHASE_CYCLE_ms;
+    unsigned long work = WETS_PHASE_WORK_us;
+    unsigned long duration = WETS_PHASE_DURATION;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"t:c:w:d:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            timers = strtoul(optarg,NULL,0);
+            break;
+        case 'c':
+            cycle = strtoul(optarg,NULL,0);
+            break;
+        case 'w':
+            work = strtoul(optarg,NULL,0);
+            break;
+        case 'd':
+            duration = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((timers == 0) || (timers > WETS_PHASE_TIMERS_MAX) ||
+        (cycle < WETS_ISR_PERIOD_ms) || (duration == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    mWork = (uint64_t)work * 1000ull;
+
+    // At most each timer on each tick
+    mLatency = calloc(timers * duration,sizeof(uint64_t));
+    if (mLatency == NULL)
+    {
+        perror("wets-phase");
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"tick_ms %u\n",(unsigned int)WETS_ISR_PERIOD_ms);
+    fprintf(out,"timers %lu\n",timers);
+    fprintf(out,"cycle %lu\n",cycle);
+
+    runTimers(out,"aligned",TRUE,(unsigned int)timers,cycle,duration);
+    runTimers(out,"staggered",FALSE,(unsigned int)timers,cycle,duration);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    free(mLatency);
+    return 0;
+}
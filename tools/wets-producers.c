@@ -0,0 +1,273 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-producers.c
+ * \brief Contention benchmark of the posted events queue.
+ *
+ * The tool runs the lock-free queue of \ref WETS_PostEvent on the host, with
+ * a growing number of producer threads that post their events through
+ * \ref WETS_postEvent as fast as they can, while the main thread is the
+ * scheduler loop: it drains the queue and dispatches the events with
+ * \ref WETS_poll. The callbacks only count the dispatches.
+ *
+ * A producer that finds the queue full yields the CPU, so that the loop can
+ * drain it also on a single CPU, and counts the refused post.
+ *
+ *     cc -O2 -I. -I<libohiboard> -DWETS_USE_POST_QUEUE=1 \
+ *        [-DWETS_USE_...] -o wets-producers \
+ *        tools/wets-producers.c wets-*.c -lpthread -lrt
+ *     ./wets-producers [-d duration] [-o report] [producers...]
+ *
+ * Each producers argument is a number of threads for a run, from 1 to 16,
+ * the default is 1, 2, 4, 8 and 16. -d is the length of each run in
+ * milli-second (default 1000). The report is a list of "key value" lines,
+ * like the one of wets-replay, that can be saved with -o.
+ */
+
+#include "wets.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (WETS_USE_POST_QUEUE == 0)
+#error "WETS: the producers benchmark requires WETS_USE_POST_QUEUE"
+#endif
+
+/*!
+ * The default length of each run in milli-second.
+ */
+#define WETS_PRODUCERS_DURATION_ms               1000u
+
+/*!
+ * The maximum number of producer threads.
+ */
+#define WETS_PRODUCERS_MAX                       16u
+
+/*!
+ * The posts accepted and refused by each producer, written only by its
+ * thread, each one on its own cache line.
+ */
+static WETS_CACHE_PADDED(uint64_t) mPosted[WETS_PRODUCERS_MAX];
+static WETS_CACHE_PADDED(uint64_t) mFull[WETS_PRODUCERS_MAX];
+
+/*!
+ * The dispatches, counted by the scheduler loop only.
+ */
+static uint64_t mDispatched = 0;
+
+static atomic_bool mRunning;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * The callback of all the events: the dispatched event is the highest bit
+ * of the status, like the scheduler does.
+ */
+static uint32_t dispatchCallback (uint32_t status)
+{
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+
+    mDispatched++;
+    return status & ~(1ul << bit);
+}
+
+/*!
+ * A producer: it posts its events in turn into the priority groups, an
+ * event still pending is merged by the loop like with \ref WETS_addEvent.
+ */
+static void* produce (void* arg)
+{
+    unsigned int id = (unsigned int)(uintptr_t)arg;
+    uint8_t priority = (uint8_t)(id % WETS_MAX_PRIORITY_LEVEL);
+    uint64_t posted = 0, full = 0;
+    unsigned int i = id;
+
+    while (atomic_load_explicit(&mRunning,memory_order_relaxed))
+    {
+        WETS_Error_t err = WETS_postEvent(dispatchCallback,priority,
+                                          1ul << (i % 32u),i);
+        if (err == WETS_ERROR_SUCCESS)
+        {
+            posted++;
+            i++;
+        }
+        else
+        {
+            full++;
+            sched_yield();
+        }
+    }
+    mPosted[id].value = posted;
+    mFull[id].value = full;
+    return NULL;
+}
+
+/*!
+ * The function runs the benchmark with a number of producers.
+ *
+ * \return TRUE when the run was completed, FALSE otherwise.
+ */
+static bool runProducers (FILE* out, unsigned int producers, unsigned long duration)
+{
+    pthread_t threads[WETS_PRODUCERS_MAX];
+
+    WETS_init();
+    WETS_removeAllPostedEvents();
+    mDispatched = 0;
+    atomic_store(&mRunning,true);
+
+    uint64_t start = getTime();
+    uint64_t end = start + ((uint64_t)duration * 1000000ull);
+    for (unsigned int i = 0; i < producers; ++i)
+    {
+        if (pthread_create(&threads[i],NULL,produce,(void*)(uintptr_t)i) != 0)
+        {
+            perror("wets-producers");
+            return FALSE;
+        }
+    }
+
+    // The scheduler loop
+    while (getTime() < end)
+    {
+        WETS_poll(WETS_POST_QUEUE_SIZE,WETS_NO_TIMEOUT);
+    }
+
+    atomic_store(&mRunning,false);
+    for (unsigned int i = 0; i < producers; ++i)
+    {
+        pthread_join(threads[i],NULL);
+    }
+    double elapsed = (double)(getTime() - start) / 1e9;
+
+    // The events still queued are dispatched, but not in the throughput
+    while (WETS_poll(WETS_POST_QUEUE_SIZE,WETS_NO_TIMEOUT) == 0)
+    {
+    }
+
+    uint64_t posted = 0, full = 0;
+    for (unsigned int i = 0; i < producers; ++i)
+    {
+        posted += mPosted[i].value;
+        full += mFull[i].value;
+    }
+
+    fprintf(out,"producers_%u_posted %llu\n",producers,(unsigned long long)posted);
+    fprintf(out,"producers_%u_full %llu\n",producers,(unsigned long long)full);
+    fprintf(out,"producers_%u_dispatched %llu\n",producers,
+            (unsigned long long)mDispatched);
+    fprintf(out,"producers_%u_throughput %.0f\n",producers,
+            (elapsed > 0) ? ((double)posted / elapsed) : 0);
+    return TRUE;
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-d duration] [-o report] [producers...]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    static const unsigned int defaultProducers[] = { 1, 2, 4, 8, 16 };
+    const char* report = NULL;
+    unsigned long duration = WETS_PRODUCERS_DURATION_ms;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"d:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            duration = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (duration == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    unsigned int runs = (optind < argc) ? (unsigned int)(argc - optind) : 5u;
+    for (unsigned int r = 0; r < runs; ++r)
+    {
+        unsigned long producers = (optind < argc) ? strtoul(argv[optind + r],NULL,0) : 1;
+        if ((producers == 0) || (producers > WETS_PRODUCERS_MAX))
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"queue_size %u\n",(unsigned int)WETS_POST_QUEUE_SIZE);
+
+    for (unsigned int r = 0; r < runs; ++r)
+    {
+        unsigned int producers = defaultProducers[r];
+        if (optind < argc)
+        {
+            producers = (unsigned int)strtoul(argv[optind + r],NULL,0);
+        }
+        if (!runProducers(out,producers,duration))
+        {
+            return 2;
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
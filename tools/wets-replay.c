@@ -0,0 +1,553 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-replay.c
+ * \brief Replay of a stream captured by the WETS recorder.
+ *
+ * The tool feeds a capture of \ref WETS_Recorder back into the scheduler on
+ * the host: the events are posted and the timers are added, changed and
+ * removed at their recorded time, while the ticks are generated by a
+ * virtual clock, or by the real one with -r. The callbacks only measure the
+ * dispatch and can burn a fixed time (-w, in nano-second) to model the
+ * work of the application.
+ *
+ * The posts refused by the groups when they were captured are tried again,
+ * "refused_rec" counts them and "refused" the posts refused by the replay,
+ * so that the overload policies are replayed too. The cyclic events start
+ * with their recorded phase when the tool is built with
+ * WETS_USE_CYCLIC_PHASE.
+ *
+ * The latency of a dispatch is measured from the post of the event, or from
+ * the tick that expired its timer. The throughput is the number of
+ * dispatches per second spent inside the scheduler. The report is a list of
+ * "key value" lines, that can be saved with -o and given back with -b to
+ * print the deltas against another library version.
+ *
+ * Build with the library and the configuration to be measured, then run:
+ *
+ *     cc -O2 -I. -I<libohiboard> [-DWETS_USE_...] -o wets-replay \
+ *        tools/wets-replay.c wets-*.c -lpthread -lrt
+ *     ./wets-replay [-r] [-w work] [-e tail] [-o report] [-b baseline]
+ *                   [-t threshold] [file]
+ *
+ * -e keeps the clock running for some milli-second after the last record.
+ * The exit code is 0 on success, 1 when the latency or the throughput is
+ * worse than the baseline by more than the threshold percentage (default
+ * 10), and 2 for a wrong capture, so that the tool can break the build.
+ */
+
+#include "wets.h"
+#include "wets-record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (WETS_MAX_PRIORITY_LEVEL > 8)
+#error "WETS: the replay supports up to 8 priority levels"
+#endif
+
+/*!
+ * The default regression threshold, in percent.
+ */
+#define WETS_REPLAY_THRESHOLD_PERCENT            10u
+
+typedef struct _WETS_ReplayMetric
+{
+    const char* key;
+    double      value;
+    int         higherIsWorse;
+
+} WETS_ReplayMetric_t;
+
+/*!
+ * The time of the posts still pending, 0 for an event posted by a timer.
+ */
+static uint64_t mPostedAt[WETS_MAX_PRIORITY_LEVEL][32];
+
+/*!
+ * The time of the last tick.
+ */
+static uint64_t mTickAt = 0;
+
+/*!
+ * The work burnt by each callback in nano-second.
+ */
+static uint64_t mWork = 0;
+
+static uint32_t* mLatencies = NULL;
+static size_t mLatenciesCount = 0;
+static size_t mLatenciesSize = 0;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t getU32 (const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/*!
+ * The callback of all the events of a priority: the dispatched event is the
+ * highest bit of the status, like the scheduler does.
+ */
+static uint32_t dispatch (uint8_t priority, uint32_t status)
+{
+    uint64_t now = getTime();
+    uint8_t bit = (uint8_t)(31 - __builtin_clz(status));
+    uint64_t from = (mPostedAt[priority][bit] > 0) ? mPostedAt[priority][bit] : mTickAt;
+
+    if (mLatenciesCount == mLatenciesSize)
+    {
+        mLatenciesSize = (mLatenciesSize > 0) ? (mLatenciesSize * 2) : 4096;
+        mLatencies = realloc(mLatencies,mLatenciesSize * sizeof(uint32_t));
+        if (mLatencies == NULL)
+        {
+            perror("wets-replay");
+            exit(2);
+        }
+    }
+    mLatencies[mLatenciesCount++] = (now > from) ? (uint32_t)(now - from) : 0;
+    mPostedAt[priority][bit] = 0;
+
+    while ((getTime() - now) < mWork)
+    {
+    }
+    return status & ~(1ul << bit);
+}
+
+#define WETS_REPLAY_CALLBACK(n)                                                \
+    static uint32_t replayCallback##n (uint32_t status)                        \
+    {                                                                          \
+        return dispatch(n,status);                                             \
+    }
+
+WETS_REPLAY_CALLBACK(0)
+WETS_REPLAY_CALLBACK(1)
+WETS_REPLAY_CALLBACK(2)
+WETS_REPLAY_CALLBACK(3)
+WETS_REPLAY_CALLBACK(4)
+WETS_REPLAY_CALLBACK(5)
+WETS_REPLAY_CALLBACK(6)
+WETS_REPLAY_CALLBACK(7)
+
+static const pEventCallback mCallbacks[8] =
+{
+    replayCallback0, replayCallback1, replayCallback2, replayCallback3,
+    replayCallback4, replayCallback5, replayCallback6, replayCallback7,
+};
+
+/*!
+ * The function dispatches all the pending events.
+ *
+ * \return The time spent in nano-second.
+ */
+static uint64_t drain (void)
+{
+    uint64_t start = getTime();
+
+    while (WETS_poll(UINT16_MAX,WETS_NO_TIMEOUT) == 0)
+    {
+    }
+    return getTime() - start;
+}
+
+static int compareLatencies (const void* a, const void* b)
+{
+    uint32_t la = *(const uint32_t*)a;
+    uint32_t lb = *(const uint32_t*)b;
+
+    return (la < lb) ? -1 : (la > lb);
+}
+
+static double getPercentile (unsigned int percent)
+{
+    if (mLatenciesCount == 0)
+    {
+        return 0;
+    }
+    return mLatencies[((mLatenciesCount - 1) * percent) / 100u];
+}
+
+/*!
+ * The function reads a baseline report and prints the deltas.
+ *
+ * \return 1 when a metric is worse than the threshold, 0 otherwise.
+ */
+static int compareBaseline (const char* name,
+                            const WETS_ReplayMetric_t* metrics,
+                            unsigned int count,
+                            unsigned long threshold)
+{
+    char key[64];
+    double value;
+    int worse = 0;
+
+    FILE* in = fopen(name,"r");
+    if (in == NULL)
+    {
+        perror(name);
+        return 2;
+    }
+
+    printf("\n%-16s %14s %14s %9s\n","metric","baseline","current","delta");
+    while (fscanf(in,"%63s %lf",key,&value) == 2)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (strcmp(key,metrics[i].key) != 0)
+            {
+                continue;
+            }
+
+            double delta = (value != 0) ? (((metrics[i].value - value) * 100.0) / value) : 0;
+            int regression = (metrics[i].higherIsWorse >= 0) &&
+                             ((metrics[i].higherIsWorse ? delta : -delta) > (double)threshold);
+            printf("%-16s %14.0f %14.0f %+8.1f%%%s\n",key,value,metrics[i].value,delta,
+                   regression ? "  REGRESSION" : "");
+            worse |= regression;
+        }
+    }
+    fclose(in);
+    return worse;
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-r] [-w work] [-e tail] [-o report] [-b baseline] [-t threshold] [file]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    const char* baseline = NULL;
+    unsigned long threshold = WETS_REPLAY_THRESHOLD_PERCENT;
+    unsigned long tail = 0;
+    int realClock = 0;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"rw:e:o:b:t:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            realClock = 1;
+            break;
+        case 'w':
+            mWork = strtoull(optarg,NULL,0);
+            break;
+        case 'e':
+            tail = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        case 'b':
+            baseline = optarg;
+            break;
+        case 't':
+            threshold = strtoul(optarg,NULL,0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* in = stdin;
+    const char* name = "<stdin>";
+    if (optind < argc)
+    {
+        name = argv[optind];
+        in = fopen(name,"rb");
+        if (in == NULL)
+        {
+            perror(name);
+            return 2;
+        }
+    }
+
+    uint8_t* capture = NULL;
+    size_t size = 0, length = 0, got;
+    do
+    {
+        if (length == size)
+        {
+            size = (size > 0) ? (size * 2) : 65536;
+            capture = realloc(capture,size);
+            if (capture == NULL)
+            {
+                perror(name);
+                return 2;
+            }
+        }
+        got = fread(capture + length,1,size - length,in);
+        length += got;
+    } while (got > 0);
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    if ((length < WETS_RECORD_HEADER_SIZE) || (memcmp(capture,"WREC",4) != 0) ||
+        (capture[4] != WETS_RECORD_VERSION))
+    {
+        fprintf(stderr,"%s: not a WETS capture\n",name);
+        return 2;
+    }
+    if (getU32(&capture[5]) != WETS_ISR_PERIOD_ms)
+    {
+        fprintf(stderr,"%s: captured with a tick of %u ms, the replay has %u ms\n",
+                name,getU32(&capture[5]),WETS_ISR_PERIOD_ms);
+        return 2;
+    }
+
+    WETS_init();
+
+    uint32_t start = getU32(&capture[9]);
+    uint32_t base = WETS_getCurrentTime();
+    uint64_t wallBase = getTime();
+    uint64_t busy = 0;
+    unsigned long records = 0, posts = 0, timers = 0;
+    unsigned long refusedRecorded = 0, refused = 0, phasesLost = 0;
+    size_t offset = WETS_RECORD_HEADER_SIZE;
+
+    // One more pass after the last record runs the tail
+    while (1)
+    {
+        const uint8_t* record = &capture[offset];
+        uint32_t target;
+        int last = (offset >= length);
+
+        if (last)
+        {
+            target = (WETS_getCurrentTime() - base) + (uint32_t)tail;
+        }
+        else
+        {
+            if ((length - offset) < WETS_RECORD_SIZE)
+            {
+                fprintf(stderr,"%s: truncated record at %zu\n",name,offset);
+                return 2;
+            }
+            target = getU32(&record[2]) - start;
+        }
+
+        // Move the clock to the time of the record
+        while ((int32_t)(target - (WETS_getCurrentTime() - base)) > 0)
+        {
+            if (realClock)
+            {
+                uint64_t next = wallBase + ((uint64_t)(WETS_getCurrentTime() - base + WETS_ISR_PERIOD_ms) * 1000000ull);
+                struct timespec ts = { .tv_sec = (time_t)(next / 1000000000ull), .tv_nsec = (long)(next % 1000000000ull) };
+                clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL);
+            }
+            mTickAt = getTime();
+            WETS_timerIsrCallback(NULL);
+            busy += drain();
+        }
+
+        if (last)
+        {
+            break;
+        }
+
+        uint8_t kind = record[0];
+        uint8_t priority = record[1];
+        uint32_t event = getU32(&record[6]);
+        uint32_t value = 0;
+        uint32_t phase = 0;
+        size_t recordSize = WETS_RECORD_VALUE_SIZE;
+
+        if ((kind == WETS_RECORD_EVENT) || (kind == WETS_RECORD_REMOVE_DELAY) ||
+            (kind == WETS_RECORD_REMOVE_CYCLIC))
+        {
+            recordSize = WETS_RECORD_SIZE;
+        }
+        else if (kind == WETS_RECORD_CYCLIC)
+        {
+            recordSize = WETS_RECORD_CYCLIC_SIZE;
+        }
+        if ((length - offset) < recordSize)
+        {
+            fprintf(stderr,"%s: truncated record at %zu\n",name,offset);
+            return 2;
+        }
+        if (recordSize > WETS_RECORD_SIZE)
+        {
+            value = getU32(&record[10]);
+        }
+        if (recordSize > WETS_RECORD_VALUE_SIZE)
+        {
+            phase = getU32(&record[14]);
+        }
+        if ((priority >= WETS_MAX_PRIORITY_LEVEL) || (event == 0))
+        {
+            fprintf(stderr,"%s: wrong event at %zu\n",name,offset);
+            return 2;
+        }
+
+        uint64_t now = getTime();
+        WETS_Error_t result = WETS_ERROR_SUCCESS;
+        switch (kind)
+        {
+        case WETS_RECORD_REFUSED_EVENT:
+            // The post is tried again, the replay can accept it or not
+            refusedRecorded++;
+            value = 0;
+            // fall through
+        case WETS_RECORD_EVENT:
+        case WETS_RECORD_PAYLOAD_EVENT:
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+            result = WETS_addPayloadEvent(mCallbacks[priority],priority,event,value);
+#else
+            result = WETS_addEvent(mCallbacks[priority],priority,event);
+#endif
+            // The latency of a merged event is measured from its first post
+            if (result == WETS_ERROR_SUCCESS)
+            {
+                mPostedAt[priority][31 - __builtin_clz(event)] = now;
+            }
+            else if (result != WETS_ERROR_EVENT_JUST_SET)
+            {
+                refused++;
+            }
+            posts++;
+            break;
+        case WETS_RECORD_DELAY:
+            WETS_addDelayEvent(mCallbacks[priority],priority,event,value);
+            timers++;
+            break;
+        case WETS_RECORD_EDIT_DELAY:
+            WETS_editDelayEvent(priority,event,value);
+            timers++;
+            break;
+        case WETS_RECORD_REMOVE_DELAY:
+            WETS_removeDelayEvent(priority,event);
+            timers++;
+            break;
+        case WETS_RECORD_CYCLIC:
+#if (WETS_USE_CYCLIC_PHASE == 1)
+            WETS_addPhasedCyclicEvent(mCallbacks[priority],priority,event,value,phase);
+#else
+            // The first event comes after a period
+            if (phase != value)
+            {
+                phasesLost++;
+            }
+            WETS_addCyclicEvent(mCallbacks[priority],priority,event,value);
+#endif
+            timers++;
+            break;
+        case WETS_RECORD_EDIT_CYCLIC:
+            WETS_editCyclicEvent(priority,event,value);
+            timers++;
+            break;
+        case WETS_RECORD_REMOVE_CYCLIC:
+            WETS_removeCyclicEvent(priority,event);
+            timers++;
+            break;
+        default:
+            fprintf(stderr,"%s: unknown record %u at %zu\n",name,kind,offset);
+            return 2;
+        }
+        busy += getTime() - now;
+        records++;
+        offset += recordSize;
+
+        // The records of the same time are dispatched together
+        if ((offset >= length) || ((length - offset) < WETS_RECORD_SIZE) ||
+            (getU32(&capture[offset + 2]) != getU32(&record[2])))
+        {
+            busy += drain();
+        }
+    }
+
+    if (phasesLost > 0)
+    {
+        fprintf(stderr,"%s: the phase of %lu cyclic events was not replayed, "
+                       "build with WETS_USE_CYCLIC_PHASE\n",name,phasesLost);
+    }
+
+    qsort(mLatencies,mLatenciesCount,sizeof(uint32_t),compareLatencies);
+
+    double average = 0;
+    for (size_t i = 0; i < mLatenciesCount; ++i)
+    {
+        average += mLatencies[i];
+    }
+    average = (mLatenciesCount > 0) ? (average / mLatenciesCount) : 0;
+
+    WETS_ReplayMetric_t metrics[] =
+    {
+        { "records",        records,                                              -1 },
+        { "posts",          posts,                                                -1 },
+        { "timers",         timers,                                               -1 },
+        { "refused_rec",    refusedRecorded,                                      -1 },
+        { "refused",        refused,                                              -1 },
+        { "dispatches",     mLatenciesCount,                                      -1 },
+        { "virtual_ms",     WETS_getCurrentTime() - base,                         -1 },
+        { "busy_ns",        busy,                                                  1 },
+        { "throughput",     (busy > 0) ? (mLatenciesCount * 1e9) / busy : 0,       0 },
+        { "latency_avg_ns", average,                                               1 },
+        { "latency_p50_ns", getPercentile(50),                                     1 },
+        { "latency_p99_ns", getPercentile(99),                                     1 },
+        { "latency_max_ns", getPercentile(100),                                   -1 },
+    };
+    unsigned int count = sizeof(metrics) / sizeof(metrics[0]);
+
+    FILE* out = (report != NULL) ? fopen(report,"w") : NULL;
+    if ((report != NULL) && (out == NULL))
+    {
+        perror(report);
+        return 2;
+    }
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        printf("%-16s %.0f\n",metrics[i].key,metrics[i].value);
+        if (out != NULL)
+        {
+            fprintf(out,"%s %.0f\n",metrics[i].key,metrics[i].value);
+        }
+    }
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+
+    free(capture);
+    free(mLatencies);
+
+    return (baseline != NULL) ? compareBaseline(baseline,metrics,count,threshold) : 0;
+}
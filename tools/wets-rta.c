@@ -0,0 +1,399 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-rta.c
+ * \brief Offline response-time analysis of a WETS cyclic task set.
+ *
+ * The tool reads a task table, one cyclic event for each line:
+ *
+ *     # priority  event  period  wcet  [deadline]
+ *     0           0x01   5       1
+ *     1           0x04   20      3     15
+ *
+ * Times are in milli-second, the event is the bit of the priority group and
+ * the deadline defaults to the period. The table can be written by hand or
+ * captured at runtime with \ref WETS_getCyclicEvents, adding the measured
+ * WCETs (see \ref WETS_Profile).
+ *
+ * The analysis follows the WETS dispatch: a callback is never preempted,
+ * the priority groups are served from 0 and, inside a group, the events
+ * from the highest bit. Each event can be blocked by the longest callback
+ * that comes after it. The timers are checked only at each tick, so an
+ * event whose period is not a multiple of the tick is released with a
+ * jitter up to one tick.
+ * The cyclic timers are re-armed from the current time, so the periods can
+ * only stretch: using the nominal period is safe.
+ *
+ * For each event the tool prints the worst-case latency (release to start),
+ * the worst-case response time (release to end) and the slack, then the
+ * utilization of each priority. An event is at risk when its response time
+ * is over a percentage of its deadline.
+ *
+ * Build and run on the host:
+ *
+ *     cc -O2 -o wets-rta tools/wets-rta.c
+ *     ./wets-rta [-t tick] [-r risk] [file]
+ *
+ * The exit code is 0 when all the deadlines are met, 1 when a deadline can
+ * be missed, and 2 for wrong input, so that the tool can break the build.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WETS_RTA_MAX_TASKS                       256u
+#define WETS_RTA_MAX_PRIORITY                    256u
+
+/*!
+ * The horizon of the analysis, a busy period longer than this number of
+ * hyperperiods means an overloaded task set.
+ */
+#define WETS_RTA_HORIZON                         1000ull
+
+/*!
+ * The default tick in milli-second, like \ref WETS_ISR_PERIOD_ms.
+ */
+#define WETS_RTA_TICK_ms                         5u
+
+/*!
+ * The default risk threshold, in percent of the deadline.
+ */
+#define WETS_RTA_RISK_PERCENT                    80u
+
+typedef struct _WETS_RtaTask
+{
+    unsigned int priority;
+    uint32_t     event;
+    uint64_t     period;
+    uint64_t     wcet;
+    uint64_t     deadline;
+    uint64_t     jitter;
+    unsigned int line;
+
+    uint64_t     response;
+    uint64_t     latency;
+    int          unbounded;
+
+} WETS_RtaTask_t;
+
+static WETS_RtaTask_t mTasks[WETS_RTA_MAX_TASKS];
+static unsigned int mTasksCount = 0;
+
+/*!
+ * The dispatch order of WETS: lower priority group first, then higher bit.
+ */
+static int compareTasks (const void* a, const void* b)
+{
+    const WETS_RtaTask_t* ta = (const WETS_RtaTask_t*)a;
+    const WETS_RtaTask_t* tb = (const WETS_RtaTask_t*)b;
+
+    if (ta->priority != tb->priority)
+    {
+        return (ta->priority < tb->priority) ? -1 : 1;
+    }
+    if (ta->event != tb->event)
+    {
+        return (ta->event > tb->event) ? -1 : 1;
+    }
+    return 0;
+}
+
+static uint64_t divCeil (uint64_t a, uint64_t b)
+{
+    return (a + b - 1u) / b;
+}
+
+/*!
+ * The function reads the task table.
+ *
+ * \return 0 on success, -1 on wrong input.
+ */
+static int readTasks (FILE* in, const char* name)
+{
+    char buffer[256];
+    unsigned int line = 0;
+
+    while (fgets(buffer,sizeof(buffer),in) != NULL)
+    {
+        line++;
+
+        char* comment = strchr(buffer,'#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+
+        unsigned int priority;
+        unsigned long event;
+        unsigned long long period, wcet, deadline;
+        int fields = sscanf(buffer,"%u %li %llu %llu %llu",&priority,(long*)&event,&period,&wcet,&deadline);
+        if (fields <= 0)
+        {
+            // Empty line
+            continue;
+        }
+        if (fields < 4)
+        {
+            fprintf(stderr,"%s:%u: expected: priority event period wcet [deadline]\n",name,line);
+            return -1;
+        }
+        if (fields == 4)
+        {
+            deadline = period;
+        }
+        if ((priority >= WETS_RTA_MAX_PRIORITY) || (event == 0u) || (event > 0xFFFFFFFFul) ||
+            (period == 0u) || (wcet == 0u) || (deadline == 0u))
+        {
+            fprintf(stderr,"%s:%u: wrong values\n",name,line);
+            return -1;
+        }
+        if (mTasksCount == WETS_RTA_MAX_TASKS)
+        {
+            fprintf(stderr,"%s:%u: too many tasks\n",name,line);
+            return -1;
+        }
+
+        WETS_RtaTask_t* t = &mTasks[mTasksCount++];
+        memset(t,0,sizeof(WETS_RtaTask_t));
+        t->priority = priority;
+        t->event    = (uint32_t)event;
+        t->period   = period;
+        t->wcet     = wcet;
+        t->deadline = deadline;
+        t->line     = line;
+    }
+    return 0;
+}
+
+/*!
+ * The function computes the worst-case response time of a task with the
+ * non-preemptive fixed-priority analysis: the task is blocked by the longest
+ * callback after it, and it is delayed by all the releases of the callbacks
+ * before it until it starts.
+ *
+ * \param[in] index: The index of the task into the sorted table.
+ * \param[in] limit: The horizon of the analysis.
+ */
+static void analyzeTask (unsigned int index, uint64_t limit)
+{
+    WETS_RtaTask_t* t = &mTasks[index];
+    uint64_t blocking = 0;
+
+    for (unsigned int j = index + 1; j < mTasksCount; ++j)
+    {
+        if (mTasks[j].wcet > blocking)
+        {
+            blocking = mTasks[j].wcet;
+        }
+    }
+
+    // The longest busy period of this level
+    uint64_t busy = blocking + t->wcet;
+    for (;;)
+    {
+        uint64_t next = blocking;
+        for (unsigned int j = 0; j <= index; ++j)
+        {
+            next += divCeil(busy + mTasks[j].jitter,mTasks[j].period) * mTasks[j].wcet;
+        }
+        if (next > limit)
+        {
+            t->unbounded = 1;
+            return;
+        }
+        if (next == busy)
+        {
+            break;
+        }
+        busy = next;
+    }
+
+    // Every job into the busy period
+    uint64_t jobs = divCeil(busy + t->jitter,t->period);
+    for (uint64_t q = 0; q < jobs; ++q)
+    {
+        uint64_t start = blocking + q * t->wcet;
+        for (;;)
+        {
+            uint64_t next = blocking + q * t->wcet;
+            for (unsigned int j = 0; j < index; ++j)
+            {
+                next += ((start + mTasks[j].jitter) / mTasks[j].period + 1u) * mTasks[j].wcet;
+            }
+            if (next > limit)
+            {
+                t->unbounded = 1;
+                return;
+            }
+            if (next == start)
+            {
+                break;
+            }
+            start = next;
+        }
+
+        uint64_t latency = t->jitter + start - q * t->period;
+        if (latency > t->latency)
+        {
+            t->latency = latency;
+        }
+        if ((latency + t->wcet) > t->response)
+        {
+            t->response = latency + t->wcet;
+        }
+    }
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-t tick] [-r risk] [file]\n",name);
+    fprintf(stderr,"  -t tick  the scheduler tick in milli-second (default %u)\n",WETS_RTA_TICK_ms);
+    fprintf(stderr,"  -r risk  the risk threshold in percent of the deadline (default %u)\n",WETS_RTA_RISK_PERCENT);
+}
+
+int main (int argc, char* argv[])
+{
+    unsigned long tick = WETS_RTA_TICK_ms;
+    unsigned long risk = WETS_RTA_RISK_PERCENT;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"t:r:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            tick = strtoul(optarg,NULL,0);
+            break;
+        case 'r':
+            risk = strtoul(optarg,NULL,0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* in = stdin;
+    const char* name = "<stdin>";
+    if (optind < argc)
+    {
+        name = argv[optind];
+        in = fopen(name,"r");
+        if (in == NULL)
+        {
+            perror(name);
+            return 2;
+        }
+    }
+    int result = readTasks(in,name);
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    if ((result != 0) || (mTasksCount == 0))
+    {
+        if (result == 0)
+        {
+            fprintf(stderr,"%s: no tasks\n",name);
+        }
+        return 2;
+    }
+
+    qsort(mTasks,mTasksCount,sizeof(WETS_RtaTask_t),compareTasks);
+    for (unsigned int i = 1; i < mTasksCount; ++i)
+    {
+        if (compareTasks(&mTasks[i - 1],&mTasks[i]) == 0)
+        {
+            fprintf(stderr,"%s:%u: duplicated event of line %u\n",name,mTasks[i].line,mTasks[i - 1].line);
+            return 2;
+        }
+    }
+
+    uint64_t limit = 0;
+    for (unsigned int i = 0; i < mTasksCount; ++i)
+    {
+        mTasks[i].jitter = ((tick > 0u) && ((mTasks[i].period % tick) != 0u)) ? tick : 0u;
+        if (mTasks[i].period > limit)
+        {
+            limit = mTasks[i].period;
+        }
+    }
+    limit *= WETS_RTA_HORIZON * mTasksCount;
+
+    int missed = 0;
+    printf("%-8s %-10s %8s %6s %8s %8s %8s %8s  %s\n",
+           "priority","event","period","wcet","deadline","latency","response","slack","status");
+    for (unsigned int i = 0; i < mTasksCount; ++i)
+    {
+        WETS_RtaTask_t* t = &mTasks[i];
+        analyzeTask(i,limit);
+
+        if (t->unbounded)
+        {
+            printf("%-8u 0x%08x %8llu %6llu %8llu %8s %8s %8s  MISS (overload)\n",
+                   t->priority,t->event,(unsigned long long)t->period,(unsigned long long)t->wcet,
+                   (unsigned long long)t->deadline,"-","-","-");
+            missed = 1;
+            continue;
+        }
+
+        const char* status = "OK";
+        if (t->response > t->deadline)
+        {
+            status = "MISS";
+            missed = 1;
+        }
+        else if ((t->response * 100u) > (t->deadline * risk))
+        {
+            status = "RISK";
+        }
+        printf("%-8u 0x%08x %8llu %6llu %8llu %8llu %8llu %8lld  %s\n",
+               t->priority,t->event,(unsigned long long)t->period,(unsigned long long)t->wcet,
+               (unsigned long long)t->deadline,(unsigned long long)t->latency,
+               (unsigned long long)t->response,(long long)t->deadline - (long long)t->response,status);
+    }
+
+    printf("\n%-8s %11s\n","priority","utilization");
+    double total = 0.0;
+    for (unsigned int i = 0; i < mTasksCount; )
+    {
+        unsigned int priority = mTasks[i].priority;
+        double u = 0.0;
+        for (; (i < mTasksCount) && (mTasks[i].priority == priority); ++i)
+        {
+            u += (double)mTasks[i].wcet / (double)mTasks[i].period;
+        }
+        total += u;
+        printf("%-8u %10.1f%%\n",priority,u * 100.0);
+    }
+    printf("%-8s %10.1f%%\n","total",total * 100.0);
+
+    return missed;
+}
@@ -0,0 +1,215 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /tools/wets-timers.c
+ * \brief Scan benchmark of the timer tables.
+ *
+ * The tool arms delay and cyclic timers that never expire during the run,
+ * then measures the time of \ref WETS_updateDelayEvents and
+ * \ref WETS_updateCyclicEvents, that scan the tables at each tick. A hot
+ * scan finds the tables already into the cache; before a cold scan the
+ * tool writes a buffer larger than the last level cache, so that the time
+ * shows the cache lines that the scan loads. On the hosts without
+ * performance counters, it is the measure of the cache misses of a scan.
+ *
+ * Build it with each layout of the tables to be compared, for example with
+ * and without WETS_USE_16BIT_TIME:
+ *
+ *     cc -O2 -I. -I<libohiboard> [-DWETS_USE_16BIT_TIME=1] \
+ *        [-DWETS_USE_...] -o wets-timers \
+ *        tools/wets-timers.c wets-*.c -lpthread -lrt
+ *     ./wets-timers [-t timers] [-n repeats] [-o report]
+ *
+ * -t is the number of timers of each table, from 0 to 32 (default 32),
+ * -n the number of scans (default 10000). The report is a list of
+ * "key value" lines, like the one of wets-replay, that can be saved with
+ * -o; the times are in nano-second per scan.
+ */
+
+#include "wets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*!
+ * The default number of scans.
+ */
+#define WETS_TIMERS_REPEATS                      10000u
+
+/*!
+ * The maximum number of timers: the slots of each table.
+ */
+#define WETS_TIMERS_MAX                          32u
+
+/*!
+ * The timeout of the timers, that never expire during the run.
+ */
+#define WETS_TIMERS_TIMEOUT_ms                   30000u
+
+/*!
+ * The size of the buffer that evicts the tables from the cache.
+ */
+#define WETS_TIMERS_EVICT_SIZE                   (64u * 1024u * 1024u)
+
+static volatile uint8_t* mEvict = NULL;
+
+static uint64_t getTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t timerCallback (uint32_t status)
+{
+    return 0;
+}
+
+/*!
+ * The function writes the buffer, one byte per cache line.
+ */
+static void evictCache (void)
+{
+    for (uint32_t i = 0; i < WETS_TIMERS_EVICT_SIZE; i += 64u)
+    {
+        mEvict[i]++;
+    }
+}
+
+/*!
+ * The function measures the scans of a table, hot and cold.
+ */
+static void runScan (FILE* out,
+                     const char* name,
+                     void (*scan)(void),
+                     unsigned long repeats)
+{
+    uint64_t start = getTime();
+    for (unsigned long r = 0; r < repeats; ++r)
+    {
+        scan();
+    }
+    double hot = (double)(getTime() - start) / repeats;
+
+    uint64_t cold = 0;
+    for (unsigned long r = 0; r < repeats; ++r)
+    {
+        evictCache();
+        start = getTime();
+        scan();
+        cold += getTime() - start;
+    }
+
+    fprintf(out,"%s_hot %.1f\n",name,hot);
+    fprintf(out,"%s_cold %.1f\n",name,(double)cold / repeats);
+}
+
+static void usage (const char* name)
+{
+    fprintf(stderr,"usage: %s [-t timers] [-n repeats] [-o report]\n",name);
+}
+
+int main (int argc, char* argv[])
+{
+    const char* report = NULL;
+    unsigned long timers = WETS_TIMERS_MAX;
+    unsigned long repeats = WETS_TIMERS_REPEATS;
+    int opt;
+
+    while ((opt = getopt(argc,argv,"t:n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            timers = strtoul(optarg,NULL,0);
+            break;
+        case 'n':
+            repeats = strtoul(optarg,NULL,0);
+            break;
+        case 'o':
+            report = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((timers > WETS_TIMERS_MAX) || (repeats == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    mEvict = calloc(WETS_TIMERS_EVICT_SIZE,1);
+    if (mEvict == NULL)
+    {
+        perror("wets-timers");
+        return 2;
+    }
+
+    WETS_init();
+    for (unsigned long i = 0; i < timers; ++i)
+    {
+        uint8_t priority = (uint8_t)(i % WETS_MAX_PRIORITY_LEVEL);
+        uint32_t event = 1ul << (i / WETS_MAX_PRIORITY_LEVEL);
+
+        if ((WETS_addDelayEvent(timerCallback,priority,event,
+                                WETS_TIMERS_TIMEOUT_ms) != WETS_ERROR_SUCCESS) ||
+            (WETS_addCyclicEvent(timerCallback,priority,event << 16,
+                                 WETS_TIMERS_TIMEOUT_ms) != WETS_ERROR_SUCCESS))
+        {
+            fprintf(stderr,"wets-timers: the timer %lu can't be armed\n",i);
+            return 2;
+        }
+    }
+
+    FILE* out = stdout;
+    if (report != NULL)
+    {
+        out = fopen(report,"w");
+        if (out == NULL)
+        {
+            perror(report);
+            return 2;
+        }
+    }
+    fprintf(out,"time_bytes %u\n",(unsigned int)sizeof(WETS_Time_t));
+    fprintf(out,"timers %lu\n",timers);
+
+    runScan(out,"delay",WETS_updateDelayEvents,repeats);
+    runScan(out,"cyclic",WETS_updateCyclicEvents,repeats);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    free((void*)mEvict);
+    return 0;
+}
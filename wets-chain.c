@@ -0,0 +1,334 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-chain.c
+ * \brief
+ */
+
+#include "wets-chain.h"
+#include "wets-event.h"
+
+#if (WETS_USE_EVENT_CHAIN == 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_EventChain
+ * \{
+ */
+
+/*!
+ * A link class.
+ */
+typedef struct _WETS_Chain
+{
+    /*!< The priority of the source events. */
+    uint8_t priority;
+
+    /*!< The mask of the source events. */
+    uint32_t events;
+
+    /*!< The source events dispatched since the last post. */
+    uint32_t completed;
+
+    /*!< The priority of the next event. */
+    uint8_t nextPriority;
+
+    /*!< The event posted when all source events are completed. */
+    uint32_t nextEvent;
+
+    /*!< The callback of the next event. */
+    pEventCallback cb;
+
+    /*!< The number of posts of the next event. */
+    uint32_t count;
+
+    /*!< The time of the first post. */
+    uint32_t firstTime;
+
+    /*!< The time of the last post. */
+    uint32_t lastTime;
+
+    /*!< Whether the next event was refused and it must be posted again. */
+    bool retry;
+
+} WETS_Chain_t;
+
+/*!
+ * The list of links.
+ */
+static WETS_Chain_t mChains[WETS_MAX_EVENT_CHAINS];
+
+/*!
+ * The union of the source events of each priority, used to skip the table
+ * for the events that have no dependent.
+ */
+static uint32_t mSources[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The number of completed links whose next event was refused with
+ * \ref WETS_ERROR_EVENT_RETRY.
+ */
+static uint8_t mRetries = 0;
+
+/*!
+ * The function computes again the source masks of each priority.
+ */
+static void updateSources (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mSources[i] = 0ul;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+    {
+        if (mChains[i].priority != WETS_NO_PRIORITY)
+        {
+            mSources[mChains[i].priority] |= mChains[i].events;
+        }
+    }
+}
+
+WETS_Error_t WETS_addEventChain (uint8_t priority,
+                                 uint32_t events,
+                                 pEventCallback cb,
+                                 uint8_t nextPriority,
+                                 uint32_t nextEvent)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(events > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(nextEvent > 0ul);
+    err |= ohiassert(nextPriority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(cb != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+        {
+            if (mChains[i].priority == WETS_NO_PRIORITY)
+            {
+                mChains[i].events       = events;
+                mChains[i].completed    = 0ul;
+                mChains[i].nextPriority = nextPriority;
+                mChains[i].nextEvent    = nextEvent;
+                mChains[i].cb           = cb;
+                mChains[i].count        = 0;
+                mChains[i].firstTime    = 0;
+                mChains[i].lastTime     = 0;
+                mChains[i].retry        = FALSE;
+                mChains[i].priority     = priority;
+
+                mSources[priority] |= events;
+                return WETS_ERROR_SUCCESS;
+            }
+        }
+        return WETS_ERROR_NO_CHAIN_AVAILABLE;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_removeEventChain (uint8_t nextPriority, uint32_t nextEvent)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(nextEvent > 0ul);
+    err |= ohiassert(nextPriority < WETS_MAX_PRIORITY_LEVEL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_NO_CHAIN_FOUND;
+
+        for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+        {
+            if ((mChains[i].priority != WETS_NO_PRIORITY)    &&
+                (mChains[i].nextPriority == nextPriority)    &&
+                (mChains[i].nextEvent == nextEvent))
+            {
+                if (mChains[i].retry)
+                {
+                    mChains[i].retry = FALSE;
+                    mRetries--;
+                }
+                mChains[i].priority = WETS_NO_PRIORITY;
+                mChains[i].cb       = NULL;
+                result = WETS_ERROR_SUCCESS;
+            }
+        }
+        updateSources();
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+void WETS_removeAllEventChains (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+    {
+        mChains[i].priority     = WETS_NO_PRIORITY;
+        mChains[i].events       = 0ul;
+        mChains[i].completed    = 0ul;
+        mChains[i].nextPriority = WETS_NO_PRIORITY;
+        mChains[i].nextEvent    = WETS_NO_EVENT;
+        mChains[i].cb           = NULL;
+        mChains[i].count        = 0;
+        mChains[i].retry        = FALSE;
+    }
+    mRetries = 0;
+    updateSources();
+}
+
+/*!
+ * The function posts the next event of a completed link. When the group
+ * refuses it with \ref WETS_ERROR_EVENT_RETRY, the link stays completed and
+ * the post is tried again after the next dispatch.
+ *
+ * \param[in] chain: The completed link.
+ */
+static void postNextEvent (WETS_Chain_t* chain)
+{
+    if (WETS_addEvent(chain->cb,chain->nextPriority,chain->nextEvent) == WETS_ERROR_EVENT_RETRY)
+    {
+        if (!chain->retry)
+        {
+            chain->retry = TRUE;
+            mRetries++;
+        }
+        return;
+    }
+
+    if (chain->retry)
+    {
+        chain->retry = FALSE;
+        mRetries--;
+    }
+    chain->completed = 0ul;
+
+    uint32_t now = WETS_getCurrentTime();
+    if (chain->count == 0)
+    {
+        chain->firstTime = now;
+    }
+    chain->lastTime = now;
+    chain->count++;
+}
+
+void WETS_resolveEventChains (uint8_t priority, uint32_t event)
+{
+    // Each dispatch can release the slot needed by a refused next event
+    if (mRetries > 0)
+    {
+        for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+        {
+            if ((mChains[i].priority != WETS_NO_PRIORITY) && mChains[i].retry)
+            {
+                postNextEvent(&mChains[i]);
+            }
+        }
+    }
+
+    // Most of the events have no dependent
+    if ((mSources[priority] & event) == 0ul)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+    {
+        WETS_Chain_t* chain = &mChains[i];
+
+        if ((chain->priority == priority) && ((chain->events & event) > 0ul))
+        {
+            chain->completed |= (chain->events & event);
+
+            if ((chain->completed == chain->events) && !chain->retry)
+            {
+                postNextEvent(chain);
+            }
+        }
+    }
+}
+
+WETS_Error_t WETS_getEventChainThroughput (uint8_t nextPriority,
+                                           uint32_t nextEvent,
+                                           uint32_t* count,
+                                           uint32_t* elapsed)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(nextEvent > 0ul);
+    err |= ohiassert(nextPriority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(count != NULL);
+    err |= ohiassert(elapsed != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_NO_CHAIN_FOUND;
+        uint32_t first = 0, last = 0;
+
+        *count = 0;
+        for (uint8_t i = 0; i < WETS_MAX_EVENT_CHAINS; ++i)
+        {
+            if ((mChains[i].priority != WETS_NO_PRIORITY)    &&
+                (mChains[i].nextPriority == nextPriority)    &&
+                (mChains[i].nextEvent == nextEvent))
+            {
+                if (mChains[i].count > 0)
+                {
+                    if ((*count == 0) || (mChains[i].firstTime < first))
+                    {
+                        first = mChains[i].firstTime;
+                    }
+                    if (mChains[i].lastTime > last)
+                    {
+                        last = mChains[i].lastTime;
+                    }
+                }
+                *count += mChains[i].count;
+                result = WETS_ERROR_SUCCESS;
+            }
+        }
+        *elapsed = last - first;
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_EVENT_CHAIN
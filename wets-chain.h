@@ -0,0 +1,151 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-chain.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_CHAIN_H
+#define __WARCOMEB_WETS_CHAIN_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_EventChain WETS Event Chains Management
+ * \ingroup  WETS
+ * \{
+ *
+ * An event chain declares that an event must be posted when one or more
+ * events have been dispatched: the pipeline acquire -> filter -> pack -> send
+ * becomes a table of links, resolved by the scheduler right after each
+ * callback returns, instead of \ref WETS_addEvent calls spread into the
+ * callbacks.
+ */
+
+#if !defined (WETS_MAX_EVENT_CHAINS)
+#define WETS_MAX_EVENT_CHAINS                    16u
+#endif
+
+/*!
+ * This function is called to add a link between events.
+ * When all the events of the mask have been dispatched, the next event is
+ * posted. A mask with a single event is a plain chain (on completion of A,
+ * post B), a mask with more events is a join (post C when both A and B have
+ * completed). A next event refused with \ref WETS_ERROR_EVENT_RETRY is
+ * posted again after each dispatch, until the group accepts it.
+ *
+ * \note All the source events of a link belong to the same priority group.
+ *       A join of events of different groups needs a relay: a plain chain
+ *       posts an event of the other group, with a callback that only
+ *       clears it, and the join waits for the relay. Each relay costs one
+ *       more dispatch, and the join can't complete before the relay group
+ *       is served.
+ *
+ * \param[in]     priority: The priority group of the source events.
+ * \param[in]       events: The mask of the source events.
+ * \param[in]           cb: The callback for the next event.
+ * \param[in] nextPriority: The priority group for the next event.
+ * \param[in]    nextEvent: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the link was created.
+ *         \arg \ref WETS_ERROR_NO_CHAIN_AVAILABLE when there isn't available
+ *                   spaces for the new link.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_addEventChain (uint8_t priority,
+                                 uint32_t events,
+                                 pEventCallback cb,
+                                 uint8_t nextPriority,
+                                 uint32_t nextEvent);
+
+/*!
+ * This function is called to remove all the links that post the selected
+ * event.
+ *
+ * \param[in] nextPriority: The priority group for the next event.
+ * \param[in]    nextEvent: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the links were removed.
+ *         \arg \ref WETS_ERROR_NO_CHAIN_FOUND when no link was found.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_removeEventChain (uint8_t nextPriority,
+                                    uint32_t nextEvent);
+
+/*!
+ * This function clear all links.
+ */
+void WETS_removeAllEventChains (void);
+
+/*!
+ * This function it is called by the scheduler (\ref WETS_loop()) when the
+ * callback of an event returns.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] priority: The priority group of the dispatched event.
+ * \param[in]    event: The dispatched event.
+ */
+void WETS_resolveEventChains (uint8_t priority, uint32_t event);
+
+/*!
+ * This function returns the throughput of a pipeline stage: how many
+ * times the links have posted the selected event, and the time elapsed
+ * between the first and the last post.
+ *
+ * \param[in] nextPriority: The priority group for the next event.
+ * \param[in]    nextEvent: The event to be notified.
+ * \param[out]       count: The number of posts.
+ * \param[out]     elapsed: The time in milli-second between the first and the
+ *                          last post.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the stage was found.
+ *         \arg \ref WETS_ERROR_NO_CHAIN_FOUND when no link was found.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_getEventChainThroughput (uint8_t nextPriority,
+                                           uint32_t nextEvent,
+                                           uint32_t* count,
+                                           uint32_t* elapsed);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_CHAIN_H
@@ -31,6 +31,12 @@
 
 #include "wets-cyclic.h"
 #include "wets-event.h"
+#if (WETS_USE_STATISTICS == 1)
+#include "wets-stats.h"
+#endif
+#if (WETS_USE_RECORDER == 1)
+#include "wets-record.h"
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -47,62 +53,294 @@ extern "C"
 #endif
 
 /*!
- * A timer for cyclic event class.
+ * The timers are stored as a structure of arrays: the deadlines are packed
+ * into a dense array, that is the only one read by the scan of
+ * \ref WETS_updateCyclicEvents, the other fields are read only when a timer
+ * expires. Each slot takes 2 * sizeof(WETS_Time_t) + 9 bytes on a 32-bit
+ * target, against the 20 bytes of the padded structure.
  */
-typedef struct _WETS_CyclicTimer
-{
-    /*!< The event priority. */
-	uint8_t priority;
 
-    /*!< The event flag to wake-up the microcontroller when timer expire. */
-    uint32_t event;
-
-    /*!< The callback that will be called when the event is fired. */
-    pEventCallback cb;
+/*!
+ * The timeout, in milli-second, of each timer.
+ */
+static WETS_Time_t mTimeouts[WETS_MAX_CYCLIC_EVENTS];
 
-    /*!< The timeout, in milli-second, of the timer. */
-    uint32_t timeout;
+/*!
+ * The cyclic delay, in milliseconds, between two events of each timer.
+ */
+static WETS_Time_t mDelays[WETS_MAX_CYCLIC_EVENTS];
 
-    /*!< The cyclic delay, in milliseconds, between two events. */
-    uint32_t delay;
+/*!
+ * The event priority of each timer, \ref WETS_NO_PRIORITY for a free timer.
+ */
+static uint8_t mPriorities[WETS_MAX_CYCLIC_EVENTS];
 
-} WETS_CyclicTimer_t;
+/*!
+ * The event flag to wake-up the microcontroller when timer expire.
+ */
+static uint32_t mEvents[WETS_MAX_CYCLIC_EVENTS];
 
 /*!
- * The list of current active timers.
+ * The callback that will be called when the event is fired.
  */
-static WETS_CyclicTimer_t mTimers[WETS_MAX_CYCLIC_EVENTS];
+static pEventCallback mCallbacks[WETS_MAX_CYCLIC_EVENTS];
 
 /*!
  * Save the number of timers that are running.
  */
 static uint8_t mCyclicTimersRunning = 0;
 
+#if (WETS_USE_CYCLIC_PHASE == 1) || (WETS_USE_CYCLIC_EXECUTIVE == 1)
+/*!
+ * The function returns the greatest common divisor of two periods.
+ */
+static uint32_t getCommonDivisor (uint32_t a, uint32_t b)
+{
+    while (b > 0)
+    {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+#endif
+
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+/*!
+ * Whether the cyclic executive is running.
+ */
+static bool mExecutive = FALSE;
+
+/*!
+ * The length of a minor frame, in milli-second.
+ */
+static uint32_t mMinorFrame = 0;
+
+/*!
+ * The number of minor frames into the hyperperiod.
+ */
+static uint16_t mFrames = 0;
+
+/*!
+ * The current minor frame.
+ */
+static uint16_t mFrame = 0;
+
+/*!
+ * The start time of the next minor frame.
+ */
+static WETS_Time_t mFrameTime = 0;
+
+/*!
+ * The number of minor frames skipped because they were reached late.
+ */
+static uint32_t mOverruns = 0;
+
+/*!
+ * Whether the next frame is the first one: it is the current time of
+ * \ref WETS_startCyclicExecutive, so its timers are called only when they
+ * are expired, not a period before.
+ */
+static bool mFirstFrame = FALSE;
+
+/*!
+ * The first entry of each minor frame, the last item is the end of the
+ * table.
+ */
+static uint16_t mFrameStart[WETS_MAX_EXECUTIVE_FRAMES + 1];
+
+/*!
+ * The timers called into the minor frames.
+ */
+static uint8_t mFrameTimers[WETS_MAX_EXECUTIVE_ENTRIES];
+
+/*!
+ * The function calls the callbacks of the expired minor frames.
+ *
+ * \param[in] currentTime: The current time.
+ */
+static void runExecutive (WETS_Time_t currentTime)
+{
+    if (!WETS_IS_TIME_EXPIRED(currentTime,mFrameTime))
+    {
+        return;
+    }
+
+    // After a stall the frames already ended are skipped, and not called
+    // back to back: the current frame keeps its time into the hyperperiod
+    uint32_t missed = (uint32_t)((WETS_Time_t)(currentTime - mFrameTime)) / mMinorFrame;
+    if (missed > 0)
+    {
+        mOverruns  += missed;
+        mFrame      = (uint16_t)((mFrame + (missed % mFrames)) % mFrames);
+        mFrameTime  = (WETS_Time_t)(mFrameTime + (missed * mMinorFrame));
+        mFirstFrame = FALSE;
+    }
+
+    for (uint16_t i = mFrameStart[mFrame]; i < mFrameStart[mFrame + 1]; i++)
+    {
+        uint8_t timer = mFrameTimers[i];
+
+        // A callback can stop the executive, changing the timers
+        if (!mExecutive)
+        {
+            return;
+        }
+        if ((mPriorities[timer] == WETS_NO_PRIORITY) ||
+            (mFirstFrame && !WETS_IS_TIME_EXPIRED(mFrameTime,mTimeouts[timer])))
+        {
+            continue;
+        }
+        (void)mCallbacks[timer](mEvents[timer]);
+    }
+
+    mFirstFrame = FALSE;
+    mFrame      = ((mFrame + 1u) == mFrames) ? 0 : (mFrame + 1u);
+    mFrameTime  = (WETS_Time_t)(mFrameTime + mMinorFrame);
+}
+
+/*!
+ * The function stops the cyclic executive, the deadlines of the timers are
+ * moved after the current time, keeping their phases.
+ *
+ * \note It must be called in critical section, in the same one that
+ *       changes the timers.
+ */
+static void stopExecutive (void)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+
+    if (!mExecutive)
+    {
+        return;
+    }
+
+    mExecutive = FALSE;
+
+    // Move the deadlines after the current time, keeping their phases
+    for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
+    {
+        if ((mPriorities[i] != WETS_NO_PRIORITY) &&
+            WETS_IS_TIME_EXPIRED(currentTime,mTimeouts[i]))
+        {
+            WETS_Time_t late = (WETS_Time_t)(currentTime - mTimeouts[i]);
+            mTimeouts[i] = (WETS_Time_t)(mTimeouts[i] + (((late / mDelays[i]) + 1u) * mDelays[i]));
+        }
+    }
+}
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+/*!
+ * The per-tick load of the timers.
+ */
+static WETS_CyclicLoad_t mLoad;
+
+/*!
+ * The function chooses the phase of a timer: each tick of the period is
+ * tried, from the last one, and the first tick where the fewest other
+ * timers expire is taken.
+ * Two timers expire together, sooner or later, when the distance of their
+ * deadlines is a multiple of the greatest common divisor of their periods,
+ * within a tick.
+ *
+ * \param[in]  timer: The index of the timer, that is skipped.
+ * \param[in] period: The period of the timer.
+ * \return The time in milli-second of the first event.
+ */
+static uint32_t allocatePhase (uint8_t timer, uint32_t period)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint32_t phase = period;
+    uint8_t best = 0xFF;
+
+    uint32_t candidate = period;
+    while ((candidate > 0) && (best > 0))
+    {
+        WETS_Time_t deadline = (WETS_Time_t)(currentTime + candidate);
+        uint8_t load = 0;
+
+        for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
+        {
+            if ((i == timer) || (mPriorities[i] == WETS_NO_PRIORITY))
+            {
+                continue;
+            }
+
+            uint32_t step = getCommonDivisor(period,mDelays[i]);
+            WETS_TimeDiff_t diff = (WETS_TimeDiff_t)((WETS_Time_t)(deadline - mTimeouts[i]));
+            uint32_t distance = (diff < 0) ? (uint32_t)(-diff) : (uint32_t)diff;
+            uint32_t r = distance % step;
+            if ((r < WETS_ISR_PERIOD_ms) || ((step - r) < WETS_ISR_PERIOD_ms))
+            {
+                load++;
+            }
+        }
+
+        if (load < best)
+        {
+            best  = load;
+            phase = candidate;
+        }
+        candidate = (candidate > WETS_ISR_PERIOD_ms) ? (candidate - WETS_ISR_PERIOD_ms) : 0;
+    }
+    return phase;
+}
+#endif
+
 /*!
  * The function searches whether there is an active timer that generates a
  * specific event.
  *
  * \param[in] priority: The priority group for the event.
  * \param[in]    event: The event to be searched.
- * \return A pointer to the timer if it is found, NULL otherwise.
+ * \return The index of the timer if it is found,
+ *         \ref WETS_MAX_CYCLIC_EVENTS otherwise.
  */
-static WETS_CyclicTimer_t* findTimer (uint8_t priority, uint32_t event)
+static uint8_t findTimer (uint8_t priority, uint32_t event)
 {
     for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; ++i)
     {
         // Whether priority and event match, return the timer
-        if ((mTimers[i].event == event) && (mTimers[i].priority == priority))
+        if ((mEvents[i] == event) && (mPriorities[i] == priority))
         {
-            return (&mTimers[i]);
+            return i;
         }
     }
-    return NULL;
+    return WETS_MAX_CYCLIC_EVENTS;
 }
 
-WETS_Error_t WETS_addCyclicEvent (pEventCallback cb,
-                                  uint8_t priority,
-                                  uint32_t event,
-                                  uint32_t timeout)
+/*!
+ * The function releases a timer.
+ *
+ * \param[in] timer: The index of the timer.
+ */
+static inline void clearTimer (uint8_t timer)
+{
+    mCallbacks[timer]  = NULL;
+    mEvents[timer]     = WETS_NO_EVENT;
+    mPriorities[timer] = WETS_NO_PRIORITY;
+    mTimeouts[timer]   = 0;
+    mDelays[timer]     = 0;
+}
+
+/*!
+ * The function adds a cyclic event.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  timeout: The timeout cycle value in milli-second.
+ * \param[in]    phase: The time in milli-second of the first event,
+ *                      \ref WETS_NO_TIMEOUT to choose it.
+ * \return The same values of \ref WETS_addCyclicEvent.
+ */
+static WETS_Error_t addCyclicEvent (pEventCallback cb,
+                                    uint8_t priority,
+                                    uint32_t event,
+                                    uint32_t timeout,
+                                    uint32_t phase)
 {
     System_Errors err = ERRORS_NO_ERROR;
 
@@ -111,32 +349,56 @@ WETS_Error_t WETS_addCyclicEvent (pEventCallback cb,
     err |= ohiassert(cb != NULL);
     // Timeout can't be zero, it is a cyclic event!
     err |= ohiassert(timeout > 0);
+    err |= ohiassert(timeout <= WETS_MAX_TIMEOUT_ms);
+    err |= ohiassert((phase <= timeout) || (phase == WETS_NO_TIMEOUT));
 
-    WETS_CyclicTimer_t* timer = NULL;
+    uint8_t timer = WETS_MAX_CYCLIC_EVENTS;
 
     if (err == ERRORS_NO_ERROR)
     {
         // Clear current event, if present
         WETS_removeEvent(priority,event);
 
+        // The search of a free timer and its filling are a single critical
+        // section, two callers can't take the same timer
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
         timer = findTimer(WETS_NO_PRIORITY, WETS_NO_EVENT);
 
         // If a timer is available
-        if (timer != NULL)
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
         {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_BEGIN();
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+            // The table of the executive refers to the timers
+            stopExecutive();
+#endif
+            if (phase == WETS_NO_TIMEOUT)
+            {
+#if (WETS_USE_CYCLIC_PHASE == 1)
+                phase = allocatePhase(timer,timeout);
+#else
+                phase = timeout;
 #endif
-            timer->cb       = cb;
-            timer->priority = priority;
-            timer->event    = event;
-            timer->timeout  = WETS_getCurrentTime() + timeout;
-            timer->delay    = timeout;
+            }
+
+            mCallbacks[timer]  = cb;
+            mPriorities[timer] = priority;
+            mEvents[timer]     = event;
+            mTimeouts[timer]   = (WETS_Time_t)(WETS_getCurrentTime() + phase);
+            mDelays[timer]     = (WETS_Time_t)timeout;
 
             // Increase the number of the current running timers.
             mCyclicTimersRunning++;
+        }
 #if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_END();
+        CRITICAL_SECTION_END();
+#endif
+
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
+        {
+#if (WETS_USE_RECORDER == 1)
+            WETS_recordCyclic(priority,event,timeout,phase);
 #endif
 
             return WETS_ERROR_SUCCESS;
@@ -150,6 +412,29 @@ WETS_Error_t WETS_addCyclicEvent (pEventCallback cb,
     return WETS_ERROR_WRONG_PARAMS;
 }
 
+WETS_Error_t WETS_addCyclicEvent (pEventCallback cb,
+                                  uint8_t priority,
+                                  uint32_t event,
+                                  uint32_t timeout)
+{
+    return addCyclicEvent(cb,priority,event,timeout,WETS_NO_TIMEOUT);
+}
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+WETS_Error_t WETS_addPhasedCyclicEvent (pEventCallback cb,
+                                        uint8_t priority,
+                                        uint32_t event,
+                                        uint32_t timeout,
+                                        uint32_t phase)
+{
+    if (phase == WETS_NO_TIMEOUT)
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+    return addCyclicEvent(cb,priority,event,timeout,phase);
+}
+#endif
+
 WETS_Error_t WETS_editCyclicEvent (uint8_t priority,
                                    uint32_t event,
                                    uint32_t timeout)
@@ -159,24 +444,41 @@ WETS_Error_t WETS_editCyclicEvent (uint8_t priority,
     err |= ohiassert(event > 0ul);
     err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
     err |= ohiassert(timeout > 0);
+    err |= ohiassert(timeout <= WETS_MAX_TIMEOUT_ms);
 
-    WETS_CyclicTimer_t* timer = NULL;
+    uint8_t timer = WETS_MAX_CYCLIC_EVENTS;
 
     if (err == ERRORS_NO_ERROR)
     {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
         timer = findTimer(priority, event);
 
         // If a timer is available
-        if (timer != NULL)
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
         {
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+            // The table of the executive refers to the timers
+            stopExecutive();
+#endif
+#if (WETS_USE_CYCLIC_PHASE == 1)
+            uint32_t phase = allocatePhase(timer,timeout);
+#else
+            uint32_t phase = timeout;
+#endif
             // Update timeout
+            mTimeouts[timer] = (WETS_Time_t)(WETS_getCurrentTime() + phase);
+            mDelays[timer]   = (WETS_Time_t)timeout;
+        }
 #if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_BEGIN();
+        CRITICAL_SECTION_END();
 #endif
-            timer->timeout = WETS_getCurrentTime() + timeout;
-            timer->delay   = timeout;
-#if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_END();
+
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
+        {
+#if (WETS_USE_RECORDER == 1)
+            WETS_record(WETS_RECORD_EDIT_CYCLIC,priority,event,timeout);
 #endif
 
             return WETS_ERROR_SUCCESS;
@@ -196,33 +498,40 @@ WETS_Error_t WETS_removeCyclicEvent (uint8_t priority, uint32_t event)
     err |= ohiassert(event > 0ul);
     err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
 
-    WETS_CyclicTimer_t* timer = NULL;
+    uint8_t timer = WETS_MAX_CYCLIC_EVENTS;
 
     if (err == ERRORS_NO_ERROR)
     {
         // Clear current event, if present
         WETS_removeEvent(priority,event);
 
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
         timer = findTimer(priority, event);
 
         // If a timer is available
-        if (timer != NULL)
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
         {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_BEGIN();
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+            // The table of the executive refers to the timers
+            stopExecutive();
 #endif
             // Update timeout
-            timer->cb       = NULL;
-            timer->event    = WETS_NO_EVENT;
-            timer->priority = WETS_NO_PRIORITY;
-            timer->timeout  = 0;
-            timer->delay    = 0;
-#if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_END();
-#endif
+            clearTimer(timer);
 
             // Decrease the number of the current running timers.
             mCyclicTimersRunning--;
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        if (timer < WETS_MAX_CYCLIC_EVENTS)
+        {
+#if (WETS_USE_RECORDER == 1)
+            WETS_record(WETS_RECORD_REMOVE_CYCLIC,priority,event,0);
+#endif
 
             return WETS_ERROR_SUCCESS;
         }
@@ -236,52 +545,363 @@ WETS_Error_t WETS_removeCyclicEvent (uint8_t priority, uint32_t event)
 
 void WETS_removeAllCyclicEvents (void)
 {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
     // Clear all timers into the list
     for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
     {
-    	mTimers[i].cb       = NULL;
-        mTimers[i].event    = WETS_NO_EVENT;
-        mTimers[i].priority = WETS_NO_PRIORITY;
-        mTimers[i].timeout  = 0;
-        mTimers[i].delay    = 0;
+        clearTimer(i);
     }
 
     // Clear the number of the current running timers.
     mCyclicTimersRunning = 0;
+
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+    mExecutive = FALSE;
+#endif
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+    mLoad.last = 0;
+    mLoad.peak = 0;
+#endif
 }
 
 void WETS_updateCyclicEvents (void)
 {
-    uint32_t currentTime = WETS_getCurrentTime();
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+    if (mExecutive)
+    {
+        runExecutive(currentTime);
+        return;
+    }
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+    uint8_t load = 0;
+#endif
 
-    // Scan all timer
+    if (mCyclicTimersRunning == 0)
+    {
+        return;
+    }
+
+    // Scan all deadlines, the other arrays are read only for the expired ones
     for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
     {
         // Whether the current time is greater than the timer timeout, set the event
-        if ((currentTime >= mTimers[i].timeout)       &&
-            (mTimers[i].priority != WETS_NO_PRIORITY) &&
-            (mTimers[i].event != WETS_NO_EVENT))
+        if (!WETS_IS_TIME_EXPIRED(currentTime,mTimeouts[i]))
+        {
+            continue;
+        }
+
+        // The expired timer is read in critical section, the event is set
+        // out of it, and the deadline is moved in a second critical section
+        // only when the timer is still the same
+        pEventCallback cb = NULL;
+        uint8_t priority = WETS_NO_PRIORITY;
+        uint32_t event = WETS_NO_EVENT;
+        WETS_Time_t timeout = 0;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (WETS_IS_TIME_EXPIRED(currentTime,mTimeouts[i]) &&
+            (mPriorities[i] != WETS_NO_PRIORITY))
+        {
+            cb       = mCallbacks[i];
+            priority = mPriorities[i];
+            event    = mEvents[i];
+            timeout  = mTimeouts[i];
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+        if (priority == WETS_NO_PRIORITY)
         {
-            // Set the event
-            WETS_addEvent(mTimers[i].cb, mTimers[i].priority, mTimers[i].event);
+            continue;
+        }
+
+        // Set the event, when the group refuses it the timer stays
+        // expired and it is tried again at the next update
+#if (WETS_USE_RECORDER == 1)
+        if (WETS_addTimerEvent(cb, priority, event, WETS_NO_TIMER) == WETS_ERROR_EVENT_RETRY)
+#else
+        if (WETS_addEvent(cb, priority, event) == WETS_ERROR_EVENT_RETRY)
+#endif
+        {
+            continue;
+        }
+#if (WETS_USE_STATISTICS == 1)
+        WETS_countStatistic(priority,WETS_COUNTER_EXPIRED);
+#endif
 
 #if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_BEGIN();
+        CRITICAL_SECTION_BEGIN();
 #endif
+        if ((mPriorities[i] == priority) && (mEvents[i] == event) &&
+            (mTimeouts[i] == timeout))
+        {
             // Update the cyclic event's informations
-            mTimers[i].timeout = currentTime + mTimers[i].delay;
+#if (WETS_USE_CYCLIC_PHASE == 1)
+            // The next deadline follows the previous one, so that the phase
+            // is kept also when the event is late: the lost periods are
+            // skipped
+            WETS_Time_t late = (WETS_Time_t)(currentTime - mTimeouts[i]);
+            mTimeouts[i] = (WETS_Time_t)(mTimeouts[i] + (((late / mDelays[i]) + 1u) * mDelays[i]));
+#else
+            mTimeouts[i] = (WETS_Time_t)(currentTime + mDelays[i]);
+#endif
+        }
 #if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_END();
+        CRITICAL_SECTION_END();
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+        load++;
+#endif
+    }
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+    mLoad.last = load;
+    if (load > mLoad.peak)
+    {
+        mLoad.peak = load;
+    }
+#endif
+}
+
+uint32_t WETS_getNextCyclicEventTimeout (void)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint32_t next = WETS_NO_TIMEOUT;
+
+    if (mCyclicTimersRunning == 0)
+    {
+        return WETS_NO_TIMEOUT;
+    }
+
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+    if (mExecutive)
+    {
+        WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mFrameTime - currentTime));
+        return (remaining <= 0) ? 0 : (uint32_t)remaining;
+    }
 #endif
+
+    for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
+    {
+        if (mPriorities[i] != WETS_NO_PRIORITY)
+        {
+            WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mTimeouts[i] - currentTime));
+
+            if (remaining <= 0)
+            {
+                return 0;
+            }
+            if ((uint32_t)remaining < next)
+            {
+                next = (uint32_t)remaining;
+            }
+        }
+    }
+    return next;
+}
+
+uint8_t WETS_getCyclicEvents (WETS_CyclicTask_t* tasks, uint8_t size)
+{
+    uint8_t count = 0;
+
+    if (ohiassert(tasks != NULL) != ERRORS_NO_ERROR)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; (i < WETS_MAX_CYCLIC_EVENTS) && (count < size); i++)
+    {
+        if (mPriorities[i] != WETS_NO_PRIORITY)
+        {
+            tasks[count].priority = mPriorities[i];
+            tasks[count].event    = mEvents[i];
+            tasks[count].period   = mDelays[i];
+            count++;
+        }
+    }
+    return count;
+}
+
+#if (WETS_USE_SNAPSHOT == 1)
+uint8_t WETS_saveCyclicEvents (WETS_SnapshotEntry_t* entries, uint8_t size)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; (i < WETS_MAX_CYCLIC_EVENTS) && (count < size); i++)
+    {
+        if (mPriorities[i] != WETS_NO_PRIORITY)
+        {
+            WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mTimeouts[i] - currentTime));
+
+            entries[count].cb        = mCallbacks[i];
+            entries[count].event     = mEvents[i];
+            entries[count].remaining = (remaining > 0) ? (uint32_t)remaining : 0;
+            entries[count].period    = mDelays[i];
+            entries[count].payload   = 0;
+            entries[count].priority  = mPriorities[i];
+            count++;
         }
     }
+    return count;
+}
+
+WETS_Error_t WETS_restoreCyclicEvent (const WETS_SnapshotEntry_t* entry)
+{
+    return addCyclicEvent(entry->cb,entry->priority,entry->event,entry->period,entry->remaining);
 }
+#endif
 
 uint8_t WETS_getCurrentCyclicEventsActive (void)
 {
     return mCyclicTimersRunning;
 }
 
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+WETS_Error_t WETS_startCyclicExecutive (void)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint32_t offsets[WETS_MAX_CYCLIC_EVENTS];
+    uint8_t order[WETS_MAX_CYCLIC_EVENTS];
+    uint8_t timers = 0;
+    uint32_t minor = 0;
+    uint32_t major = 1;
+
+    if (mCyclicTimersRunning == 0)
+    {
+        return WETS_ERROR_NO_TIMER_FOUND;
+    }
+
+    // The callbacks are not called while the table is built
+    mExecutive = FALSE;
+
+    for (uint8_t i = 0; i < WETS_MAX_CYCLIC_EVENTS; i++)
+    {
+        if (mPriorities[i] == WETS_NO_PRIORITY)
+        {
+            continue;
+        }
+
+        uint32_t period = mDelays[i];
+        if ((period % WETS_ISR_PERIOD_ms) != 0)
+        {
+            return WETS_ERROR_WRONG_PARAMS;
+        }
+
+        // The phase of the timer, rounded to the tick where it expires
+        WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mTimeouts[i] - currentTime));
+        uint32_t offset = (remaining <= 0) ? 0 : ((uint32_t)remaining % period);
+        offset = ((offset + WETS_ISR_PERIOD_ms - 1u) / WETS_ISR_PERIOD_ms) * WETS_ISR_PERIOD_ms;
+        offsets[i] = (offset == period) ? 0 : offset;
+
+        minor = getCommonDivisor(getCommonDivisor(minor,period),offsets[i]);
+
+        uint32_t factor = period / getCommonDivisor(major,period);
+        if (((uint64_t)major * factor) > ((uint64_t)WETS_MAX_EXECUTIVE_FRAMES * period))
+        {
+            return WETS_ERROR_NO_FRAME_AVAILABLE;
+        }
+        major *= factor;
+
+        // Insert the timer ordered by priority, then by importance of event
+        uint8_t j = timers++;
+        while ((j > 0) &&
+               ((mPriorities[order[j - 1]] > mPriorities[i]) ||
+                ((mPriorities[order[j - 1]] == mPriorities[i]) && (mEvents[order[j - 1]] < mEvents[i]))))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    if ((major / minor) > WETS_MAX_EXECUTIVE_FRAMES)
+    {
+        return WETS_ERROR_NO_FRAME_AVAILABLE;
+    }
+
+    // The frame f starts at currentTime + f * minor, a timer is called into
+    // the frames where its phase plus a multiple of its period falls
+    uint16_t frames = (uint16_t)(major / minor);
+    uint16_t count = 0;
+    for (uint16_t f = 0; f < frames; f++)
+    {
+        mFrameStart[f] = count;
+        for (uint8_t j = 0; j < timers; j++)
+        {
+            uint8_t timer = order[j];
+            uint32_t period = mDelays[timer];
+            if ((((f * minor) + period - offsets[timer]) % period) == 0)
+            {
+                if (count == WETS_MAX_EXECUTIVE_ENTRIES)
+                {
+                    return WETS_ERROR_NO_FRAME_AVAILABLE;
+                }
+                mFrameTimers[count++] = timer;
+            }
+        }
+    }
+    mFrameStart[frames] = count;
+
+    // The first frame is the current time, for the timers already expired
+    mMinorFrame = minor;
+    mFrames     = frames;
+    mFrame      = 0;
+    mFrameTime  = currentTime;
+    mFirstFrame = TRUE;
+    mOverruns   = 0;
+    mExecutive  = TRUE;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_stopCyclicExecutive (void)
+{
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    stopExecutive();
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+}
+
+uint32_t WETS_getCyclicExecutiveOverruns (void)
+{
+    return mOverruns;
+}
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+WETS_Error_t WETS_getCyclicLoad (WETS_CyclicLoad_t* load)
+{
+    if (ohiassert(load != NULL) != ERRORS_NO_ERROR)
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    *load = mLoad;
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_clearCyclicLoad (void)
+{
+    mLoad.peak = mLoad.last;
+}
+#endif
+
 /*!
  * \}
  */
@@ -67,6 +67,29 @@ WETS_Error_t WETS_addCyclicEvent (pEventCallback cb,
                                   uint32_t event,
                                   uint32_t cycle);
 
+#if (WETS_USE_CYCLIC_PHASE == 1)
+/*!
+ * This function adds a cyclic event like \ref WETS_addCyclicEvent, with an
+ * explicit phase instead of the one chosen by the scheduler.
+ * \ref WETS_addCyclicEvent places the first event of a timer on the tick
+ * of its period where the fewest other timers expire, so that the timers
+ * with the same period don't fire all on the same tick.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]    cycle: The timeout cycle value in milli-second.
+ * \param[in]    phase: The time in milli-second of the first event, from 0
+ *                      to the cycle value.
+ * \return The same values of \ref WETS_addCyclicEvent.
+ */
+WETS_Error_t WETS_addPhasedCyclicEvent (pEventCallback cb,
+                                        uint8_t priority,
+                                        uint32_t event,
+                                        uint32_t cycle,
+                                        uint32_t phase);
+#endif
+
 /*!
  * This function is called to stop the timer that has already been started
  * to generate a cyclic event.
@@ -115,6 +138,151 @@ void WETS_removeAllCyclicEvents (void);
  */
 void WETS_updateCyclicEvents (void);
 
+/*!
+ * This function returns the time until the first timer expires.
+ *
+ * \return The time in milli-second, 0 when a timer is already expired, or
+ *         \ref WETS_NO_TIMEOUT when there isn't any timer.
+ */
+uint32_t WETS_getNextCyclicEventTimeout (void);
+
+/*!
+ * A registered cyclic event, as seen by the schedulability analysis.
+ */
+typedef struct _WETS_CyclicTask
+{
+    /*!< The priority group of the event. */
+    uint8_t  priority;
+
+    /*!< The event. */
+    uint32_t event;
+
+    /*!< The period in milli-second. */
+    uint32_t period;
+
+} WETS_CyclicTask_t;
+
+/*!
+ * This function copies the registered cyclic events, so that the task set
+ * captured at runtime can be verified on the host with tools/wets-rta.c.
+ *
+ * \param[out] tasks: The array to be filled.
+ * \param[in]   size: The size of the array.
+ * \return The number of copied events.
+ */
+uint8_t WETS_getCyclicEvents (WETS_CyclicTask_t* tasks, uint8_t size);
+
+#if (WETS_USE_SNAPSHOT == 1)
+/*!
+ * This function copies the timers, for \ref WETS_snapshot.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[out] entries: The array to be filled.
+ * \param[in]     size: The size of the array.
+ * \return The number of copied timers.
+ */
+uint8_t WETS_saveCyclicEvents (WETS_SnapshotEntry_t* entries, uint8_t size);
+
+/*!
+ * This function adds again a saved timer with its phase, for
+ * \ref WETS_restore.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] entry: The saved timer, with the remaining time already
+ *                   rebased, from 1 to the period.
+ * \return The same values of \ref WETS_addCyclicEvent.
+ */
+WETS_Error_t WETS_restoreCyclicEvent (const WETS_SnapshotEntry_t* entry);
+#endif
+
+#if (WETS_USE_CYCLIC_PHASE == 1)
+/*!
+ * The number of cyclic events expired on the ticks.
+ */
+typedef struct _WETS_CyclicLoad
+{
+    /*!< The events expired on the last tick. */
+    uint8_t last;
+
+    /*!< The most events expired on a single tick. */
+    uint8_t peak;
+
+} WETS_CyclicLoad_t;
+
+/*!
+ * This function returns the per-tick load of the cyclic events.
+ *
+ * \param[out] load: The load.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the load was copied.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_getCyclicLoad (WETS_CyclicLoad_t* load);
+
+/*!
+ * This function clear the peak of the per-tick load.
+ */
+void WETS_clearCyclicLoad (void);
+#endif
+
+#if (WETS_USE_CYCLIC_EXECUTIVE == 1)
+#if !defined (WETS_MAX_EXECUTIVE_FRAMES)
+#define WETS_MAX_EXECUTIVE_FRAMES                32u
+#endif
+
+#if !defined (WETS_MAX_EXECUTIVE_ENTRIES)
+#define WETS_MAX_EXECUTIVE_ENTRIES               64u
+#endif
+
+/*!
+ * This function turns the registered cyclic events into a cyclic
+ * executive. The hyperperiod (the least common multiple of the periods) is
+ * divided into minor frames (the greatest common divisor of the periods and
+ * of the current phases), and the list of the callbacks of each frame is
+ * built once, ordered by priority and by event.
+ * Then, at each minor frame, \ref WETS_updateCyclicEvents calls directly
+ * the callbacks of the frame, without scanning the timers and without
+ * posting the events. The other events are dispatched as usual.
+ *
+ * \note The callbacks receive only their own event, and the returned
+ *       value is ignored.
+ * \note Adding, changing or removing a cyclic event stops the executive,
+ *       since the table refers to the timers: the function must be called
+ *       again.
+ *
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the executive was started.
+ *         \arg \ref WETS_ERROR_NO_TIMER_FOUND when there isn't any cyclic
+ *                   event.
+ *         \arg \ref WETS_ERROR_NO_FRAME_AVAILABLE when the frames or the
+ *                   callbacks of the hyperperiod don't fit into
+ *                   \ref WETS_MAX_EXECUTIVE_FRAMES and
+ *                   \ref WETS_MAX_EXECUTIVE_ENTRIES.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when a period is not a
+ *                   multiple of \ref WETS_ISR_PERIOD_ms.
+ */
+WETS_Error_t WETS_startCyclicExecutive (void);
+
+/*!
+ * This function stops the cyclic executive, the cyclic events are generated
+ * again by their timers, with the same phases.
+ */
+void WETS_stopCyclicExecutive (void);
+
+/*!
+ * This function returns the number of minor frames skipped since
+ * \ref WETS_startCyclicExecutive: when the scheduler reaches the executive
+ * after the end of some frames, they are not called back to back, the
+ * executive goes on from the current frame.
+ *
+ * \return The number of skipped frames.
+ */
+uint32_t WETS_getCyclicExecutiveOverruns (void);
+#endif
+
 /*!
  * \}
  */
@@ -31,6 +31,12 @@
 
 #include "wets-delay.h"
 #include "wets-event.h"
+#if (WETS_USE_STATISTICS == 1)
+#include "wets-stats.h"
+#endif
+#if (WETS_USE_RECORDER == 1)
+#include "wets-record.h"
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -47,53 +53,154 @@ extern "C"
 #endif
 
 /*!
- * A timer class.
+ * The timers are stored as a structure of arrays: the deadlines are packed
+ * into a dense array, that is the only one read by the scan of
+ * \ref WETS_updateDelayEvents, the other fields are read only when a timer
+ * expires. Each slot takes sizeof(WETS_Time_t) + 9 bytes on a 32-bit
+ * target, against the 16 bytes of the padded structure.
  */
-typedef struct _WETS_Timer
-{
-    /*!< The event priority. */
-	uint8_t priority;
 
-    /*!< The event flag to wake-up the microcontroller when timer expire. */
-    uint32_t event;
-
-    /*!< The callback that will be called when the event is fired. */
-    pEventCallback cb;
+/*!
+ * The timeout, in milli-second, of each timer.
+ */
+static WETS_Time_t mTimeouts[WETS_MAX_DELAYED_EVENTS];
 
-    /*!< The timeout, in milli-second, of the timer. */
-    uint32_t timeout;
+/*!
+ * The event priority of each timer, \ref WETS_NO_PRIORITY for a free timer.
+ */
+static uint8_t mPriorities[WETS_MAX_DELAYED_EVENTS];
 
-} WETS_Timer_t;
+/*!
+ * The event flag to wake-up the microcontroller when timer expire.
+ */
+static uint32_t mEvents[WETS_MAX_DELAYED_EVENTS];
 
 /*!
- * The list of current active timers.
+ * The callback that will be called when the event is fired.
  */
-static WETS_Timer_t mTimers[WETS_MAX_DELAYED_EVENTS];
+static pEventCallback mCallbacks[WETS_MAX_DELAYED_EVENTS];
 
 /*!
  * Save the number of timers that are running.
  */
 static uint8_t mTimersRunning = 0;
 
+#if (WETS_USE_DELAY_REARM == 1)
+/*!
+ * Whether a timer is expired and waits for its callback, that can re-arm
+ * it. A fired timer is not running and can't be found by its event.
+ */
+static bool mFired[WETS_MAX_DELAYED_EVENTS];
+
+/*!
+ * The fired timer of the running callback. With the priority threads the
+ * callbacks of the groups run at the same time, each thread has its own.
+ */
+#if (WETS_USE_PRIORITY_THREADS == 1)
+static _Thread_local uint8_t mFiredTimer = WETS_NO_TIMER;
+#else
+static uint8_t mFiredTimer = WETS_NO_TIMER;
+#endif
+#endif
+
+/*!
+ * The function checks whether a timer is counting.
+ *
+ * \param[in] timer: The index of the timer.
+ * \return TRUE when the timer is running, FALSE otherwise.
+ */
+static inline bool isTimerArmed (uint8_t timer)
+{
+#if (WETS_USE_DELAY_REARM == 1)
+    return (mPriorities[timer] != WETS_NO_PRIORITY) && !mFired[timer];
+#else
+    return (mPriorities[timer] != WETS_NO_PRIORITY);
+#endif
+}
+
 /*!
  * The function searches whether there is an active timer that generates a
  * specific event.
  *
  * \param[in] priority: The priority group for the event.
  * \param[in]    event: The event to be searched.
- * \return A pointer to the timer if it is found, NULL otherwise.
+ * \return The index of the timer if it is found,
+ *         \ref WETS_MAX_DELAYED_EVENTS otherwise.
  */
-static WETS_Timer_t* findTimer (uint8_t priority, uint32_t event)
+static uint8_t findTimer (uint8_t priority, uint32_t event)
 {
     for (uint8_t i = 0; i < WETS_MAX_DELAYED_EVENTS; ++i)
     {
         // Whether priority and event match, return the timer
-        if ((mTimers[i].event == event) && (mTimers[i].priority == priority))
+        if ((mEvents[i] == event) && (mPriorities[i] == priority))
         {
-            return (&mTimers[i]);
+#if (WETS_USE_DELAY_REARM == 1)
+            if (mFired[i])
+            {
+                continue;
+            }
+#endif
+            return i;
         }
     }
-    return NULL;
+    return WETS_MAX_DELAYED_EVENTS;
+}
+
+/*!
+ * The function releases a timer.
+ *
+ * \param[in] timer: The index of the timer.
+ */
+static inline void clearTimer (uint8_t timer)
+{
+    mCallbacks[timer]  = NULL;
+    mEvents[timer]     = WETS_NO_EVENT;
+    mPriorities[timer] = WETS_NO_PRIORITY;
+    mTimeouts[timer]   = 0;
+}
+
+WETS_Error_t WETS_armDelayEvent (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint32_t timeout)
+{
+    uint8_t timer = findTimer(WETS_NO_PRIORITY, WETS_NO_EVENT);
+
+    // If a timer is available
+    if (timer < WETS_MAX_DELAYED_EVENTS)
+    {
+        mCallbacks[timer]  = cb;
+        mPriorities[timer] = priority;
+        mEvents[timer]     = event;
+        mTimeouts[timer]   = (WETS_Time_t)(WETS_getCurrentTime() + timeout);
+
+        // Increase the number of the current running timers.
+        mTimersRunning++;
+        return WETS_ERROR_SUCCESS;
+    }
+    else
+    {
+        return WETS_ERROR_NO_TIMER_AVAILABLE;
+    }
+}
+
+WETS_Error_t WETS_disarmDelayEvent (uint8_t priority, uint32_t event)
+{
+    uint8_t timer = findTimer(priority, event);
+
+    // If a timer is available
+    if (timer < WETS_MAX_DELAYED_EVENTS)
+    {
+        clearTimer(timer);
+
+        // Decrease the number of the current running timers.
+        mTimersRunning--;
+        return WETS_ERROR_SUCCESS;
+    }
+    else
+    {
+        return WETS_ERROR_NO_TIMER_FOUND;
+    }
 }
 
 WETS_Error_t WETS_addDelayEvent (pEventCallback cb,
@@ -106,10 +213,9 @@ WETS_Error_t WETS_addDelayEvent (pEventCallback cb,
     err |= ohiassert(event > 0ul);
     err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
     err |= ohiassert(cb != NULL);
+    err |= ohiassert(timeout <= WETS_MAX_TIMEOUT_ms);
     ohiassert(timeout > 0);
 
-    WETS_Timer_t* timer = NULL;
-
     if (err == ERRORS_NO_ERROR)
     {
         // Clear current event, if present
@@ -117,31 +223,22 @@ WETS_Error_t WETS_addDelayEvent (pEventCallback cb,
 
         if (timeout)
         {
-            timer = findTimer(WETS_NO_PRIORITY, WETS_NO_EVENT);
-
-            // If a timer is available
-            if (timer != NULL)
-            {
+            // The search of a free timer and its filling are a single
+            // critical section, two callers can't take the same timer
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                CRITICAL_SECTION_BEGIN();
+            CRITICAL_SECTION_BEGIN();
 #endif
-                timer->cb       = cb;
-                timer->priority = priority;
-                timer->event    = event;
-                timer->timeout  = WETS_getCurrentTime() + timeout;
-
-                // Increase the number of the current running timers.
-                mTimersRunning++;
+            WETS_Error_t result = WETS_armDelayEvent(cb,priority,event,timeout);
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                CRITICAL_SECTION_END();
+            CRITICAL_SECTION_END();
 #endif
-
-                return WETS_ERROR_SUCCESS;
-            }
-            else
+#if (WETS_USE_RECORDER == 1)
+            if (result == WETS_ERROR_SUCCESS)
             {
-                return WETS_ERROR_NO_TIMER_AVAILABLE;
+                WETS_record(WETS_RECORD_DELAY,priority,event,timeout);
             }
+#endif
+            return result;
         }
         else
         {
@@ -161,23 +258,31 @@ WETS_Error_t WETS_editDelayEvent (uint8_t priority,
 
     err |= ohiassert(event > 0ul);
     err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(timeout <= WETS_MAX_TIMEOUT_ms);
 
-    WETS_Timer_t* timer = NULL;
+    uint8_t timer = WETS_MAX_DELAYED_EVENTS;
 
     if (err == ERRORS_NO_ERROR)
     {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
         timer = findTimer(priority, event);
 
         // If a timer is available
-        if (timer != NULL)
+        if (timer < WETS_MAX_DELAYED_EVENTS)
         {
             // Update timeout
+            mTimeouts[timer] = (WETS_Time_t)(WETS_getCurrentTime() + timeout);
+        }
 #if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_BEGIN();
+        CRITICAL_SECTION_END();
 #endif
-            timer->timeout  = WETS_getCurrentTime() + timeout;
-#if (WETS_USE_CRITICAL_SECTION == 1)
-            CRITICAL_SECTION_END();
+
+        if (timer < WETS_MAX_DELAYED_EVENTS)
+        {
+#if (WETS_USE_RECORDER == 1)
+            WETS_record(WETS_RECORD_EDIT_DELAY,priority,event,timeout);
 #endif
 
             return WETS_ERROR_SUCCESS;
@@ -197,74 +302,208 @@ WETS_Error_t WETS_removeDelayEvent (uint8_t priority, uint32_t event)
     err |= ohiassert(event > 0ul);
     err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
 
-    WETS_Timer_t* timer = NULL;
-
     if (err == ERRORS_NO_ERROR)
     {
-        timer = findTimer(priority, event);
-
-        // If a timer is available
-        if (timer != NULL)
-        {
-            // Update timeout
-            timer->cb       = NULL;
-            timer->event    = WETS_NO_EVENT;
-            timer->priority = WETS_NO_PRIORITY;
-            timer->timeout  = 0;
-
-            // Decrease the number of the current running timers.
-            mTimersRunning--;
-
-            return WETS_ERROR_SUCCESS;
-        }
-        else
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        WETS_Error_t result = WETS_disarmDelayEvent(priority,event);
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+#if (WETS_USE_RECORDER == 1)
+        if (result == WETS_ERROR_SUCCESS)
         {
-            return WETS_ERROR_NO_TIMER_FOUND;
+            WETS_record(WETS_RECORD_REMOVE_DELAY,priority,event,0);
         }
+#endif
+        return result;
     }
     return WETS_ERROR_WRONG_PARAMS;
 }
 
 void WETS_removeAllDelayEvents (void)
 {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
     // Clear all timers into the list
     for (uint8_t i = 0; i < WETS_MAX_DELAYED_EVENTS; i++)
     {
-    	mTimers[i].cb       = NULL;
-        mTimers[i].event    = WETS_NO_EVENT;
-        mTimers[i].priority = WETS_NO_PRIORITY;
-        mTimers[i].timeout  = 0;
+#if (WETS_USE_DELAY_REARM == 1)
+        // The fired timers are released with their pending events
+        if (mFired[i])
+        {
+            continue;
+        }
+#endif
+        clearTimer(i);
     }
 
     // Clear the number of the current running timers.
     mTimersRunning = 0;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
 }
 
 void WETS_updateDelayEvents (void)
 {
-    uint32_t currentTime = WETS_getCurrentTime();
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+
+    if (mTimersRunning == 0)
+    {
+        return;
+    }
 
-    // Scan all timer
+    // Scan all deadlines, the other arrays are read only for the expired ones
     for (uint8_t i = 0; i < WETS_MAX_DELAYED_EVENTS; i++)
     {
         // Whether the current time is greater than the timer timeout, set the event
-        if ((currentTime >= mTimers[i].timeout)       &&
-            (mTimers[i].priority != WETS_NO_PRIORITY) &&
-            (mTimers[i].event != WETS_NO_EVENT))
+        if (!WETS_IS_TIME_EXPIRED(currentTime,mTimeouts[i]))
+        {
+            continue;
+        }
+
+        // The expired timer is taken in critical section, the event is set
+        // out of it, and the timer is updated in a second critical section
+        // only when it is still the same
+        bool expired = FALSE;
+        pEventCallback cb = NULL;
+        uint8_t priority = WETS_NO_PRIORITY;
+        uint32_t event = WETS_NO_EVENT;
+        WETS_Time_t timeout = 0;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (WETS_IS_TIME_EXPIRED(currentTime,mTimeouts[i]) && isTimerArmed(i))
+        {
+            expired  = TRUE;
+            cb       = mCallbacks[i];
+            priority = mPriorities[i];
+            event    = mEvents[i];
+            timeout  = mTimeouts[i];
+#if (WETS_USE_DELAY_REARM == 1)
+            // A fired timer can't be found, nor removed, by its event: the
+            // callback can release it before the end of the update
+            mFired[i] = TRUE;
+#endif
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+        if (!expired)
         {
-            // Set the event
-            WETS_addEvent(mTimers[i].cb, mTimers[i].priority, mTimers[i].event);
+            continue;
+        }
 
+        // Set the event, when the group refuses it the timer stays
+        // expired and it is tried again at the next update
+#if (WETS_USE_DELAY_REARM == 1) || (WETS_USE_RECORDER == 1)
+        WETS_Error_t result = WETS_addTimerEvent(cb, priority, event, i);
+#else
+        WETS_Error_t result = WETS_addEvent(cb, priority, event);
+#endif
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (result == WETS_ERROR_EVENT_RETRY)
+        {
+#if (WETS_USE_DELAY_REARM == 1)
+            mFired[i] = FALSE;
+#endif
+        }
+#if (WETS_USE_DELAY_REARM == 1)
+        else if (result == WETS_ERROR_SUCCESS)
+        {
+            // The slot is kept for the callback, that can re-arm it
+            mTimersRunning--;
+        }
+        else
+        {
             // Delete the delayed event's informations
-            mTimers[i].cb       = NULL;
-            mTimers[i].event    = WETS_NO_EVENT;
-            mTimers[i].priority = WETS_NO_PRIORITY;
-            mTimers[i].timeout  = 0;
+            clearTimer(i);
+            mFired[i] = FALSE;
+            mTimersRunning--;
+        }
+        (void)timeout;
+#else
+        else if ((mPriorities[i] == priority) && (mEvents[i] == event) &&
+                 (mTimeouts[i] == timeout))
+        {
+            // Delete the delayed event's informations, when it wasn't
+            // removed or started again in the meanwhile
+            clearTimer(i);
 
             // Decrease the number of the current running timers.
             mTimersRunning--;
         }
+#endif
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+#if (WETS_USE_STATISTICS == 1)
+        if (result != WETS_ERROR_EVENT_RETRY)
+        {
+            WETS_countStatistic(priority,WETS_COUNTER_EXPIRED);
+        }
+#endif
+    }
+}
+
+#if (WETS_USE_SNAPSHOT == 1)
+uint8_t WETS_saveDelayEvents (WETS_SnapshotEntry_t* entries, uint8_t size)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; (i < WETS_MAX_DELAYED_EVENTS) && (count < size); i++)
+    {
+        if (isTimerArmed(i))
+        {
+            WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mTimeouts[i] - currentTime));
+
+            entries[count].cb        = mCallbacks[i];
+            entries[count].event     = mEvents[i];
+            entries[count].remaining = (remaining > 0) ? (uint32_t)remaining : 0;
+            entries[count].period    = 0;
+            entries[count].payload   = 0;
+            entries[count].priority  = mPriorities[i];
+            count++;
+        }
     }
+    return count;
+}
+#endif
+
+uint32_t WETS_getNextDelayEventTimeout (void)
+{
+    WETS_Time_t currentTime = (WETS_Time_t)WETS_getCurrentTime();
+    uint32_t next = WETS_NO_TIMEOUT;
+
+    if (mTimersRunning == 0)
+    {
+        return WETS_NO_TIMEOUT;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_DELAYED_EVENTS; i++)
+    {
+        if (isTimerArmed(i))
+        {
+            WETS_TimeDiff_t remaining = (WETS_TimeDiff_t)((WETS_Time_t)(mTimeouts[i] - currentTime));
+
+            if (remaining <= 0)
+            {
+                return 0;
+            }
+            if ((uint32_t)remaining < next)
+            {
+                next = (uint32_t)remaining;
+            }
+        }
+    }
+    return next;
 }
 
 uint8_t WETS_getCurrentDelayEventsActive (void)
@@ -272,6 +511,70 @@ uint8_t WETS_getCurrentDelayEventsActive (void)
     return mTimersRunning;
 }
 
+#if (WETS_USE_DELAY_REARM == 1)
+WETS_Error_t WETS_rearmDelayEvent (uint32_t timeout)
+{
+    uint8_t timer = mFiredTimer;
+
+    if (timer == WETS_NO_TIMER)
+    {
+        return WETS_ERROR_NO_TIMER_FOUND;
+    }
+    if ((timeout == 0) || (timeout > WETS_MAX_TIMEOUT_ms))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    // The slot still holds callback, priority and event
+    mTimeouts[timer] = (WETS_Time_t)(WETS_getCurrentTime() + timeout);
+    mFired[timer]    = FALSE;
+    mTimersRunning++;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+#if (WETS_USE_RECORDER == 1)
+    // The replay adds the timer again, its callback doesn't re-arm it
+    WETS_record(WETS_RECORD_DELAY,mPriorities[timer],mEvents[timer],timeout);
+#endif
+
+    // A timer is re-armed only once for each expiration
+    mFiredTimer = WETS_NO_TIMER;
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_enterDelayEvent (uint8_t timer)
+{
+    mFiredTimer = timer;
+}
+
+void WETS_leaveDelayEvent (void)
+{
+    if (mFiredTimer != WETS_NO_TIMER)
+    {
+        WETS_releaseDelayEvent(mFiredTimer);
+        mFiredTimer = WETS_NO_TIMER;
+    }
+}
+
+void WETS_releaseDelayEvent (uint8_t timer)
+{
+    if ((timer < WETS_MAX_DELAYED_EVENTS) && mFired[timer])
+    {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        clearTimer(timer);
+        mFired[timer] = FALSE;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+    }
+}
+#endif
+
 /*!
  * \}
  */
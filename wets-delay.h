@@ -102,6 +102,29 @@ WETS_Error_t WETS_editDelayEvent (uint8_t priority,
                                   uint32_t event,
                                   uint32_t timeout);
 
+/*!
+ * These functions start and stop a delayed event like
+ * \ref WETS_addDelayEvent and \ref WETS_removeDelayEvent, without their
+ * critical section, for the modules that change the timers together with
+ * their own tables. The pending event is not removed, and the recorder is
+ * left to the caller.
+ *
+ * \note They must be called in critical section. They not must be called
+ *       in other cases.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  timeout: The timeout in milli-second, greater than zero.
+ * \return The same values of \ref WETS_addDelayEvent and
+ *         \ref WETS_removeDelayEvent.
+ */
+WETS_Error_t WETS_armDelayEvent (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint32_t timeout);
+WETS_Error_t WETS_disarmDelayEvent (uint8_t priority, uint32_t event);
+
 /*!
  * This function clear all delayed events. It stop all timers.
  */
@@ -124,6 +147,72 @@ void WETS_updateDelayEvents (void);
  */
 uint8_t WETS_getCurrentDelayEventsActive (void);
 
+/*!
+ * This function returns the time until the first timer expires.
+ *
+ * \return The time in milli-second, 0 when a timer is already expired, or
+ *         \ref WETS_NO_TIMEOUT when there isn't any timer.
+ */
+uint32_t WETS_getNextDelayEventTimeout (void);
+
+#if (WETS_USE_SNAPSHOT == 1)
+/*!
+ * This function copies the armed timers, for \ref WETS_snapshot.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[out] entries: The array to be filled.
+ * \param[in]     size: The size of the array.
+ * \return The number of copied timers.
+ */
+uint8_t WETS_saveDelayEvents (WETS_SnapshotEntry_t* entries, uint8_t size);
+#endif
+
+#if (WETS_USE_DELAY_REARM == 1)
+/*!
+ * This function is called by the callback of a delayed event to start
+ * again its timer, reusing the expired slot without any search. It is the
+ * fast path of the periodic tasks with a variable period, that otherwise
+ * call \ref WETS_addDelayEvent from their callback.
+ * When the callback returns without re-arm, the timer is released.
+ *
+ * \note With \ref WETS_USE_PRIORITY_THREADS the running callback is the one
+ *       of the calling thread.
+ *
+ * \param[in] timeout: The next timeout in milli-second.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the timer was re-armed.
+ *         \arg \ref WETS_ERROR_NO_TIMER_FOUND when the running callback
+ *                   was not fired by a delayed event, or it was already
+ *                   re-armed.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_rearmDelayEvent (uint32_t timeout);
+
+/*!
+ * These functions are called by the dispatcher around the callback of an
+ * event fired by the timer, that is released on leave when the callback
+ * didn't re-arm it.
+ *
+ * \note They not must be called in other cases.
+ *
+ * \param[in] timer: The fired timer.
+ */
+void WETS_enterDelayEvent (uint8_t timer);
+void WETS_leaveDelayEvent (void);
+
+/*!
+ * This function releases a fired timer whose event was removed before its
+ * dispatch.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] timer: The fired timer.
+ */
+void WETS_releaseDelayEvent (uint8_t timer);
+#endif
+
 /*!
  * \}
  */
@@ -32,13 +32,64 @@
 #include "wets-event.h"
 #include "wets-delay.h"
 #include "wets-cyclic.h"
+#include "wets-profile.h"
+#if (WETS_USE_POST_QUEUE == 1)
+#include "wets-post.h"
+#endif
+#if (WETS_USE_OFFLOAD == 1)
+#include "wets-offload.h"
+#endif
+#if (WETS_USE_EVENT_CHAIN == 1)
+#include "wets-chain.h"
+#endif
+#if (WETS_USE_EVENT_GROUP == 1)
+#include "wets-group.h"
+#endif
+#if (WETS_USE_EVENT_ID == 1)
+#include "wets-id.h"
+#endif
+#if (WETS_USE_STATE_MACHINE == 1)
+#include "wets-fsm.h"
+#endif
+#if (WETS_USE_STATISTICS == 1)
+#include "wets-stats.h"
+#endif
+#if (WETS_USE_IO_SOURCES == 1)
+#include "wets-io.h"
+#endif
+#if (WETS_USE_IPC == 1)
+#include "wets-ipc.h"
+#endif
+#if (WETS_USE_PRIORITY_THREADS == 1)
+#include "wets-thread.h"
+#endif
+#if (WETS_USE_RECORDER == 1)
+#include "wets-record.h"
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/*!
+ * The number of slots of each priority group. It can be reduced to save
+ * memory, in this case the events exceeding the slots are handled by the
+ * overload policy of the group, see \ref WETS_Overload_t.
+ */
+#if !defined (WETS_MAX_EVENTS_PER_PRIORITY)
 #define WETS_MAX_EVENTS_PER_PRIORITY             32u
+#endif
+
+/*!
+ * The callbacks called by each iteration of \ref WETS_loop: one event, or
+ * a whole pass over a group with the drain mode.
+ */
+#if (WETS_USE_DRAIN_MODE == 1)
+#define WETS_LOOP_EVENTS                         WETS_MAX_EVENTS_PER_PRIORITY
+#else
+#define WETS_LOOP_EVENTS                         1u
+#endif
 
 /*!
  * A event class.
@@ -50,26 +101,126 @@ typedef struct _WETS_Event
 
     pEventCallback cb;
 
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    /*!< The user value attached to the event. */
+    uintptr_t      payload;
+#endif
+
+#if (WETS_USE_AGING == 1) || (WETS_USE_WAIT_STATISTICS == 1)
+    /*!< The time when the event was posted. */
+    uint32_t       time;
+#endif
+
+#if (WETS_USE_DELAY_REARM == 1)
+    /*!< The fired delayed timer of the event, or \ref WETS_NO_TIMER. */
+    uint8_t        timer;
+#endif
+
 } WETS_Event_t;
 
+/*!
+ * The events of a priority group. With \ref WETS_USE_CACHE_ALIGNMENT, each
+ * status word, polled by the dispatcher and written by every producer of the
+ * group, has its own cache line, apart from the slots and from the other
+ * groups.
+ */
 typedef struct _WETS_Events
 {
-    WETS_Event_t event[WETS_MAX_EVENTS_PER_PRIORITY];
+    WETS_Event_t event[WETS_MAX_EVENTS_PER_PRIORITY] WETS_CACHE_ALIGNED;
 
-    uint32_t     status;
+    uint32_t     status WETS_CACHE_ALIGNED;
 
-} WETS_Events_t;
+} WETS_CACHE_ALIGNED WETS_Events_t;
 
 static WETS_Events_t mEvents[WETS_MAX_PRIORITY_LEVEL];
 
-static bool mNewEventOccurred = FALSE;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+/*!
+ * The event dispatched by each priority group, out of its slot, whose
+ * payload is read by the callback.
+ */
+static const WETS_Event_t* mRunning[WETS_MAX_PRIORITY_LEVEL];
+#endif
+
+/*!
+ * Written by every producer under the lock of \ref setEvent.
+ */
+static WETS_CACHE_PADDED(bool) mNewEventOccurred = { FALSE };
 
 /*!
  *
  */
-static uint32_t mCurrentTime = 0;
+static WETS_CACHE_PADDED(uint32_t) mCurrentTime = { 0 };
+
+/*!
+ * Written by the tick and cleared by the loop, away from the current time
+ * read by every dispatch.
+ */
+static WETS_CACHE_PADDED(bool) mIsTimerFired = { FALSE };
+
+#if (WETS_USE_AGING == 1)
+/*!
+ * The aging threshold of each priority.
+ */
+static uint32_t mAgingThreshold[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The time of the last aging check, the events can't age between two ticks.
+ */
+static uint32_t mAgingTime = 0;
+#endif
+
+#if (WETS_USE_WAIT_STATISTICS == 1)
+static WETS_WaitStatistics_t mWaitStatistics[WETS_MAX_PRIORITY_LEVEL];
+#endif
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+/*!
+ * An event waiting into the overflow queue.
+ */
+typedef struct _WETS_Spilled
+{
+    uint8_t        priority;
+
+    uint32_t       event;
+
+    pEventCallback cb;
+
+    uintptr_t      payload;
+
+    uint8_t        timer;
+
+} WETS_Spilled_t;
+
+/*!
+ * The policy of each priority when its slots are all used.
+ */
+static WETS_Overload_t mOverloadPolicy[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The number of events lost by each priority.
+ */
+static uint32_t mOverloadDrops[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The overflow queue, shared by the priorities with the spill policy.
+ */
+static WETS_Spilled_t mSpilled[WETS_OVERLOAD_QUEUE_SIZE];
 
-static bool mIsTimerFired = FALSE;
+static uint8_t mSpilledCount = 0;
+#endif
+
+#if (WETS_USE_CPU_BUDGET == 1)
+/*!
+ * The CPU budget of each priority.
+ */
+static WETS_Budget_t mBudgets[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The start time of the current replenishment period of each priority.
+ */
+static uint32_t mBudgetStart[WETS_MAX_PRIORITY_LEVEL];
+#endif
 
 /*!
  * TODO
@@ -93,7 +244,8 @@ static WETS_Event_t* findMostImportantEvent (uint8_t priority)
 {
     uint32_t event = 0x80000000ul;
 
-    for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
+    // Scan the bits of the status word, not the slots
+    for (uint8_t i = 0; i < 32u; ++i)
     {
         if ((mEvents[priority].status & event) > 0)
         {
@@ -104,216 +256,1542 @@ static WETS_Event_t* findMostImportantEvent (uint8_t priority)
     return NULL;
 }
 
-WETS_Error_t WETS_addEvent (pEventCallback cb, uint8_t priority, uint32_t event)
+#if (WETS_USE_CPU_BUDGET == 1)
+/*!
+ * The function checks whether a priority group has spent its budget into
+ * the current period. The budget is replenished at each period boundary.
+ *
+ * \param[in] priority: The priority group.
+ * \return TRUE when the group can't be dispatched, FALSE otherwise.
+ */
+static bool isBudgetExhausted (uint8_t priority)
 {
-    System_Errors err = ERRORS_NO_ERROR;
-
-    err |= ohiassert(event > 0ul);
-    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
-    err |= ohiassert(cb != NULL);
+    WETS_Budget_t* b = &mBudgets[priority];
 
-    if (err == ERRORS_NO_ERROR)
+    if (b->period == 0ul)
     {
-        if (!WETS_isEvent(priority,event))
-        {
-            for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
-            {
-                if (mEvents[priority].event[i].event == WETS_NO_EVENT)
-                {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_BEGIN();
-#endif
-
-                    // Add event...
-                    mNewEventOccurred = TRUE;
-
-                    mEvents[priority].event[i].cb    = cb;
-                    mEvents[priority].event[i].event = event;
-
-                    mEvents[priority].status |= event;
-
-#if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_END();
-#endif
+        return FALSE;
+    }
 
-                    return WETS_ERROR_SUCCESS;
-                }
-            }
-            return WETS_ERROR_EVENT_BUFFER_FULL;
-        }
-        return WETS_ERROR_EVENT_JUST_SET;
+    uint32_t elapsed = mCurrentTime.value - mBudgetStart[priority];
+    if (elapsed >= b->period)
+    {
+        // Keep the periods aligned to the first one
+        mBudgetStart[priority] += elapsed - (elapsed % b->period);
+        b->used = 0;
     }
-    return WETS_ERROR_WRONG_PARAMS;
+    return (b->used >= b->budget);
 }
 
-bool WETS_isEvent (uint8_t priority, uint32_t event)
+/*!
+ * The function charges the time of a callback to its priority group.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]  elapsed: The time spent, in milli-second.
+ */
+static void chargeBudget (uint8_t priority, uint32_t elapsed)
 {
-    ohiassert(event > 0ul);
-    ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    WETS_Budget_t* b = &mBudgets[priority];
 
-    return ((mEvents[priority].status & event) > 0ul);
+    if ((b->period == 0ul) || (elapsed == 0ul))
+    {
+        return;
+    }
+
+    if ((b->used < b->budget) && ((b->used + elapsed) >= b->budget))
+    {
+        b->throttled++;
+    }
+    b->used += elapsed;
 }
 
-WETS_Error_t WETS_removeEvent (uint8_t priority, uint32_t event)
+/*!
+ * The function returns the time until the first replenishment of the
+ * priority groups that have pending events but no budget.
+ *
+ * \return The time in milli-second, or \ref WETS_NO_TIMEOUT.
+ */
+static uint32_t getNextBudgetTimeout (void)
 {
-    System_Errors err = ERRORS_NO_ERROR;
+    uint32_t next = WETS_NO_TIMEOUT;
 
-    err |= ohiassert(event > 0ul);
-    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
-
-    if (err == ERRORS_NO_ERROR)
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
     {
-        if (WETS_isEvent(priority,event))
+        if ((mEvents[i].status > 0ul) && isBudgetExhausted(i))
         {
-            for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
+            uint32_t remaining = mBudgets[i].period - (mCurrentTime.value - mBudgetStart[i]);
+            if (remaining < next)
             {
-                if ((mEvents[priority].event[i].event != WETS_NO_EVENT) &&
-                   ((mEvents[priority].event[i].event & event) > 0))
-                {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_BEGIN();
+                next = remaining;
+            }
+        }
+    }
+    return next;
+}
 #endif
 
-                    // Clear event...
-                    mEvents[priority].event[i].event = WETS_NO_EVENT;
-                    mEvents[priority].event[i].cb    = NULL;
-
-                    mEvents[priority].status &= ~event;
-
-#if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_END();
+/*!
+ * The function checks whether a priority group has events that can be
+ * dispatched now.
+ *
+ * \param[in] priority: The priority group.
+ * \return TRUE when the group is ready, FALSE otherwise.
+ */
+static bool isReady (uint8_t priority)
+{
+#if (WETS_USE_CPU_BUDGET == 1)
+    return (mEvents[priority].status > 0ul) && !isBudgetExhausted(priority);
+#else
+    return (mEvents[priority].status > 0ul);
 #endif
+}
 
-                    return WETS_ERROR_SUCCESS;
-                }
-            }
-            return WETS_ERROR_NO_EVENT_FOUND;
-        }
-        else
+/*!
+ * The function checks whether any priority group has events that can be
+ * dispatched now. The groups without budget are not considered.
+ *
+ * \return TRUE when an event can be dispatched, FALSE otherwise.
+ */
+static bool isAnyReadyEvent (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        if (isReady(i))
         {
-            return WETS_ERROR_NO_EVENT_FOUND;
+            return TRUE;
         }
     }
-    return WETS_ERROR_WRONG_PARAMS;
+    return FALSE;
 }
 
-void WETS_removeAllEvents (void)
+#if (WETS_USE_AGING == 1)
+/*!
+ * The function searches the oldest pending event that waits more than the
+ * aging threshold of its priority.
+ *
+ * \param[out] priority: The priority group of the event found.
+ * \return A pointer to the event if it is found, NULL otherwise.
+ */
+static WETS_Event_t* findAgedEvent (uint8_t* priority)
 {
-    // Clear all event into the list
-    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    WETS_Event_t* aged = NULL;
+    uint32_t now = mCurrentTime.value;
+    uint32_t oldest = 0;
+
+    // The first priority is already served first
+    for (uint8_t i = 1; i < WETS_MAX_PRIORITY_LEVEL; ++i)
     {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-        CRITICAL_SECTION_BEGIN();
-#endif
-        mEvents[i].status = 0ul;
+        if (!isReady(i) || (mAgingThreshold[i] == 0ul))
+        {
+            continue;
+        }
 
         for (uint8_t j = 0; j < WETS_MAX_EVENTS_PER_PRIORITY; ++j)
         {
-            mEvents[i].event[j].cb    = NULL;
-            mEvents[i].event[j].event = WETS_NO_EVENT;
+            WETS_Event_t* e = &mEvents[i].event[j];
+            uint32_t wait = now - e->time;
+
+            if ((e->event != WETS_NO_EVENT)          &&
+                ((mEvents[i].status & e->event) > 0) &&
+                (wait >= mAgingThreshold[i])         &&
+                ((aged == NULL) || (wait > oldest)))
+            {
+                aged      = e;
+                oldest    = wait;
+                *priority = i;
+            }
         }
-#if (WETS_USE_CRITICAL_SECTION == 1)
-        CRITICAL_SECTION_END();
-#endif
     }
+    return aged;
 }
 
-bool WETS_isAnyEvent (void)
+WETS_Error_t WETS_setAgingThreshold (uint8_t priority, uint32_t threshold)
 {
-    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    if (ohiassert(priority < WETS_MAX_PRIORITY_LEVEL) == ERRORS_NO_ERROR)
     {
-        if (mEvents[i].status > 0ul) return TRUE;
+        mAgingThreshold[priority] = threshold;
+        return WETS_ERROR_SUCCESS;
     }
-    return FALSE;
+    return WETS_ERROR_WRONG_PARAMS;
 }
+#endif
 
-void WETS_init (void)
+#if (WETS_USE_WAIT_STATISTICS == 1)
+WETS_Error_t WETS_getWaitStatistics (uint8_t priority,
+                                     WETS_WaitStatistics_t* statistics)
 {
-    WETS_removeAllEvents();
-    WETS_removeAllDelayEvents();
-    WETS_removeAllCyclicEvents();
-}
+    System_Errors err = ERRORS_NO_ERROR;
 
-void WETS_loop (void)
-{
-    for (;;)
-    {
-#if (WETS_USE_LOW_POWER_MODE == 1)
-        bool lowPowerMode = TRUE;
-#endif
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(statistics != NULL);
 
-        for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
-        {
-            if (mEvents[i].status > 0)
-            {
-                WETS_Event_t* event = findMostImportantEvent(i);
-                if (event != NULL)
-                {
-                    uint32_t status = 0;
+    if (err == ERRORS_NO_ERROR)
+    {
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_BEGIN();
+        CRITICAL_SECTION_BEGIN();
 #endif
-                    status = mEvents[i].status;
-                    mEvents[i].status = 0;
+        *statistics = mWaitStatistics[priority];
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_END();
+        CRITICAL_SECTION_END();
 #endif
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
 
-                    status = event->cb(status);
-
+void WETS_clearWaitStatistics (void)
+{
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_BEGIN();
+    CRITICAL_SECTION_BEGIN();
 #endif
-                    // Delete reference to this event...
-                    event->event       = WETS_NO_EVENT;
-                    event->cb          = NULL;
-                    mEvents[i].status |= status;
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mWaitStatistics[i].count    = 0;
+        mWaitStatistics[i].total    = 0;
+        mWaitStatistics[i].max      = 0;
+        mWaitStatistics[i].promoted = 0;
+    }
 #if (WETS_USE_CRITICAL_SECTION == 1)
-                    CRITICAL_SECTION_END();
+    CRITICAL_SECTION_END();
+#endif
+}
 #endif
-                    break;
-                }
-            }
-        }
 
-        while (!WETS_isAnyEvent())
-        {
-            WETS_doBeforeSleep();
-            // TODO: go to sleep!
-            WETS_doAfterWakeUp();
+/*!
+ * The function fills a slot with the event, and sets it as pending.
+ *
+ * \param[in] priority: The priority group for the event.
+ * \param[in]     slot: The slot to be filled.
+ * \param[in]       cb: The callback for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event.
+ * \param[in]    timer: The fired delayed timer of the event.
+ *
+ * \note It must be called in critical section, in the same one that found
+ *       the free slot.
+ */
+static void setEvent (uint8_t priority,
+                      WETS_Event_t* slot,
+                      pEventCallback cb,
+                      uint32_t event,
+                      uintptr_t payload,
+                      uint8_t timer)
+{
+    // Add event...
+    mNewEventOccurred.value = TRUE;
 
-//#if (WETS_USE_LOW_POWER_MODE == 1)
-//        if (lowPowerMode)
-//        {
-//            // TODO: call low power mode enable function!
-//        }
-//#endif
+    slot->cb    = cb;
+    slot->event = event;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    slot->payload = payload;
+#else
+    (void)payload;
+#endif
+#if (WETS_USE_AGING == 1) || (WETS_USE_WAIT_STATISTICS == 1)
+    slot->time = mCurrentTime.value;
+#endif
+#if (WETS_USE_DELAY_REARM == 1)
+    slot->timer = timer;
+#else
+    (void)timer;
+#endif
 
-            if (mIsTimerFired)
-            {
-                WETS_updateDelayEvents();
-                WETS_updateCyclicEvents();
-                mIsTimerFired = FALSE;
-            }
-        }
-    }
+    mEvents[priority].status |= event;
 }
 
-void WETS_timerIsrCallback (void * unused)
+/*!
+ * The function takes the fired delayed timer of an event that is removed
+ * without dispatch, to be given to \ref releaseTimer.
+ *
+ * \note It must be called in critical section, in the same one that
+ *       removes the event.
+ *
+ * \param[in] slot: The slot of the event.
+ * \return The timer of the event, \ref WETS_NO_TIMER when it has none.
+ */
+static inline uint8_t takeTimer (WETS_Event_t* slot)
 {
-#if (WETS_USE_CRITICAL_SECTION == 1)
-    CRITICAL_SECTION_BEGIN();
-#endif
-    mCurrentTime += WETS_ISR_PERIOD_ms;
-    mIsTimerFired = TRUE;
-#if (WETS_USE_CRITICAL_SECTION == 1)
-    CRITICAL_SECTION_END();
+#if (WETS_USE_DELAY_REARM == 1)
+    uint8_t timer = slot->timer;
+    slot->timer = WETS_NO_TIMER;
+    return timer;
+#else
+    (void)slot;
+    return WETS_NO_TIMER;
 #endif
 }
 
-uint32_t WETS_getCurrentTime (void)
+/*!
+ * The function releases a timer taken by \ref takeTimer, out of the
+ * critical section.
+ *
+ * \param[in] timer: The timer, \ref WETS_NO_TIMER for none.
+ */
+static inline void releaseTimer (uint8_t timer)
+{
+#if (WETS_USE_DELAY_REARM == 1)
+    if (timer != WETS_NO_TIMER)
+    {
+        WETS_releaseDelayEvent(timer);
+    }
+#else
+    (void)timer;
+#endif
+}
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+static WETS_Error_t addEvent (pEventCallback cb,
+                              uint8_t priority,
+                              uint32_t event,
+                              uintptr_t payload,
+                              uint8_t timer);
+
+/*!
+ * The function searches a spilled event.
+ *
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be searched, \ref WETS_NO_EVENT for the
+ *                      first event of the priority.
+ * \return The index into the overflow queue if it is found,
+ *         \ref WETS_OVERLOAD_QUEUE_SIZE otherwise.
+ */
+static uint8_t findSpilledEvent (uint8_t priority, uint32_t event)
+{
+    for (uint8_t i = 0; i < mSpilledCount; ++i)
+    {
+        if ((mSpilled[i].priority == priority) &&
+            ((event == WETS_NO_EVENT) || (mSpilled[i].event == event)))
+        {
+            return i;
+        }
+    }
+    return WETS_OVERLOAD_QUEUE_SIZE;
+}
+
+/*!
+ * The function deletes an event from the overflow queue, keeping the order
+ * of the others.
+ *
+ * \param[in] index: The index into the overflow queue.
+ */
+static void deleteSpilledEvent (uint8_t index)
+{
+    for (uint8_t i = index; (i + 1) < mSpilledCount; ++i)
+    {
+        mSpilled[i] = mSpilled[i + 1];
+    }
+    mSpilledCount--;
+}
+
+/*!
+ * The function applies the overload policy of the priority when there
+ * isn't a free slot for the event.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event.
+ * \param[in]    timer: The fired delayed timer of the event.
+ * \param[out] released: The timer of the evicted event, to be released out
+ *                       of the critical section.
+ * \return The same values of \ref WETS_addEvent.
+ *
+ * \note It must be called in critical section, in the same one of
+ *       \ref addEvent.
+ */
+static WETS_Error_t overloadEvent (pEventCallback cb,
+                                   uint8_t priority,
+                                   uint32_t event,
+                                   uintptr_t payload,
+                                   uint8_t timer,
+                                   uint8_t* released)
+{
+    WETS_Error_t result = WETS_ERROR_EVENT_BUFFER_FULL;
+
+    switch (mOverloadPolicy[priority])
+    {
+    case WETS_OVERLOAD_DROP_LOWEST:
+    {
+        // The least important pending event leaves its slot to a more
+        // important one
+        uint32_t status = mEvents[priority].status;
+        uint32_t lowest = status & (~status + 1ul);
+        WETS_Event_t* victim = ((lowest > 0ul) && (lowest < event)) ? findEvent(priority,lowest) : NULL;
+        if (victim != NULL)
+        {
+            mEvents[priority].status &= ~lowest;
+            *released = takeTimer(victim);
+            setEvent(priority,victim,cb,event,payload,timer);
+            result = WETS_ERROR_SUCCESS;
+        }
+        break;
+    }
+
+    case WETS_OVERLOAD_SPILL:
+    {
+        result = WETS_ERROR_SUCCESS;
+        uint8_t index = findSpilledEvent(priority,event);
+        if (index < WETS_OVERLOAD_QUEUE_SIZE)
+        {
+            mSpilled[index].payload = payload;
+            result = WETS_ERROR_EVENT_JUST_SET;
+        }
+        else if (mSpilledCount < WETS_OVERLOAD_QUEUE_SIZE)
+        {
+            mSpilled[mSpilledCount].priority = priority;
+            mSpilled[mSpilledCount].event    = event;
+            mSpilled[mSpilledCount].cb       = cb;
+            mSpilled[mSpilledCount].payload  = payload;
+            mSpilled[mSpilledCount].timer    = timer;
+            mSpilledCount++;
+        }
+        else
+        {
+            result = WETS_ERROR_EVENT_BUFFER_FULL;
+        }
+        // The event is dropped only when also the overflow queue is full
+        if (result != WETS_ERROR_EVENT_BUFFER_FULL)
+        {
+            return result;
+        }
+        break;
+    }
+
+    case WETS_OVERLOAD_RETRY:
+        // The caller keeps the event and tries again later
+        return WETS_ERROR_EVENT_RETRY;
+
+    case WETS_OVERLOAD_DROP_NEWEST:
+    default:
+        break;
+    }
+
+    // One event was lost: the new one or the evicted one
+    mOverloadDrops[priority]++;
+#if (WETS_USE_STATISTICS == 1)
+    WETS_countStatistic(priority,WETS_COUNTER_DROPPED);
+#endif
+    return result;
+}
+
+/*!
+ * The function moves the first spilled event of the priority into the free
+ * slot of the group.
+ *
+ * \param[in] priority: The priority group.
+ */
+static void refillEvent (uint8_t priority)
+{
+    if (mSpilledCount == 0)
+    {
+        return;
+    }
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    WETS_Spilled_t spilled = { WETS_NO_PRIORITY, WETS_NO_EVENT, NULL, 0, WETS_NO_TIMER };
+    uint8_t index = findSpilledEvent(priority,WETS_NO_EVENT);
+    if (index < WETS_OVERLOAD_QUEUE_SIZE)
+    {
+        spilled = mSpilled[index];
+        deleteSpilledEvent(index);
+    }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+
+    if (spilled.priority != WETS_NO_PRIORITY)
+    {
+        addEvent(spilled.cb,spilled.priority,spilled.event,spilled.payload,spilled.timer);
+    }
+}
+#endif
+
+/*!
+ * The function stores the event into the first free slot of its priority
+ * group.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event, it is discarded when
+ *                      \ref WETS_USE_EVENT_PAYLOAD is not enabled.
+ * \param[in]    timer: The fired delayed timer of the event, or
+ *                      \ref WETS_NO_TIMER.
+ * \return The same values of \ref WETS_addEvent. With a timer,
+ *         \ref WETS_ERROR_SUCCESS means that the event took it.
+ */
+static WETS_Error_t addEvent (pEventCallback cb,
+                              uint8_t priority,
+                              uint32_t event,
+                              uintptr_t payload,
+                              uint8_t timer)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(cb != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_EVENT_JUST_SET;
+        uint8_t released = WETS_NO_TIMER;
+
+        // The check, the search of a free slot and its filling are a single
+        // critical section: two producers can't take the same slot, or store
+        // the same event twice
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (!WETS_isEvent(priority,event))
+        {
+            result = WETS_ERROR_EVENT_BUFFER_FULL;
+            for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
+            {
+                if (mEvents[priority].event[i].event == WETS_NO_EVENT)
+                {
+                    setEvent(priority,&mEvents[priority].event[i],cb,event,payload,timer);
+
+#if (WETS_USE_STATISTICS == 1)
+                    WETS_countStatistic(priority,WETS_COUNTER_POSTED);
+#endif
+                    result = WETS_ERROR_SUCCESS;
+                    break;
+                }
+            }
+            if (result != WETS_ERROR_SUCCESS)
+            {
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+                result = overloadEvent(cb,priority,event,payload,timer,&released);
+#elif (WETS_USE_STATISTICS == 1)
+                WETS_countStatistic(priority,WETS_COUNTER_DROPPED);
+#endif
+            }
+        }
+        else
+        {
+#if (WETS_USE_EVENT_PAYLOAD == 1) || (WETS_USE_DELAY_REARM == 1)
+            WETS_Event_t* e = findEvent(priority,event);
+            if (e != NULL)
+            {
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+                // The last payload wins when the event is merged
+                e->payload = payload;
+#endif
+#if (WETS_USE_DELAY_REARM == 1)
+                // The pending event can take the timer when it has none
+                if ((timer != WETS_NO_TIMER) && (e->timer == WETS_NO_TIMER))
+                {
+                    e->timer = timer;
+                    result = WETS_ERROR_SUCCESS;
+                }
+#endif
+            }
+#endif
+#if (WETS_USE_STATISTICS == 1)
+            WETS_countStatistic(priority,WETS_COUNTER_MERGED);
+#endif
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+        releaseTimer(released);
+#if (WETS_USE_EVENT_PAYLOAD == 0)
+        (void)payload;
+#endif
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+/*!
+ * The function notifies the modules that wait for the new events.
+ *
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The added event.
+ */
+static inline void notifyEvent (uint8_t priority, uint32_t event)
+{
+#if (WETS_USE_PRIORITY_THREADS == 1)
+    WETS_notifyPriorityThread(priority);
+#endif
+#if (WETS_USE_EVENT_GROUP == 1)
+    WETS_resolveEventGroups(priority,event);
+#endif
+    (void)priority;
+    (void)event;
+}
+
+#if (WETS_USE_RECORDER == 1)
+/*!
+ * The function records a post of the application: the accepted and the
+ * merged events with their kind, the refused ones with the error, so that
+ * the replay is loaded by the same posts.
+ *
+ * \param[in]     kind: The record kind of an accepted event.
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The posted event.
+ * \param[in]    value: The value of the kind.
+ * \param[in]      err: The result of the post.
+ */
+static void recordEvent (WETS_RecordKind_t kind,
+                         uint8_t priority,
+                         uint32_t event,
+                         uint32_t value,
+                         WETS_Error_t err)
+{
+    if ((err == WETS_ERROR_SUCCESS) || (err == WETS_ERROR_EVENT_JUST_SET))
+    {
+        WETS_record(kind,priority,event,value);
+    }
+    else if (err != WETS_ERROR_WRONG_PARAMS)
+    {
+        WETS_record(WETS_RECORD_REFUSED_EVENT,priority,event,(uint32_t)err);
+    }
+}
+#endif
+
+WETS_Error_t WETS_addEvent (pEventCallback cb, uint8_t priority, uint32_t event)
+{
+    WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_ADD_EVENT);
+    WETS_Error_t err = addEvent(cb,priority,event,0,WETS_NO_TIMER);
+    WETS_PROFILE_END(WETS_PROFILE_SITE_ADD_EVENT);
+#if (WETS_USE_RECORDER == 1)
+    recordEvent(WETS_RECORD_EVENT,priority,event,0,err);
+#endif
+    if (err == WETS_ERROR_SUCCESS)
+    {
+        notifyEvent(priority,event);
+    }
+    return err;
+}
+
+#if (WETS_USE_DELAY_REARM == 1) || (WETS_USE_RECORDER == 1)
+WETS_Error_t WETS_addTimerEvent (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint8_t timer)
+{
+    WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_ADD_EVENT);
+    WETS_Error_t err = addEvent(cb,priority,event,0,timer);
+    WETS_PROFILE_END(WETS_PROFILE_SITE_ADD_EVENT);
+    if (err == WETS_ERROR_SUCCESS)
+    {
+        notifyEvent(priority,event);
+    }
+    return err;
+}
+#endif
+
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+WETS_Error_t WETS_addPayloadEvent (pEventCallback cb,
+                                   uint8_t priority,
+                                   uint32_t event,
+                                   uintptr_t payload)
+{
+    WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_ADD_EVENT);
+    WETS_Error_t err = addEvent(cb,priority,event,payload,WETS_NO_TIMER);
+    WETS_PROFILE_END(WETS_PROFILE_SITE_ADD_EVENT);
+#if (WETS_USE_RECORDER == 1)
+    recordEvent(WETS_RECORD_PAYLOAD_EVENT,priority,event,(uint32_t)payload,err);
+#endif
+    if (err == WETS_ERROR_SUCCESS)
+    {
+        notifyEvent(priority,event);
+    }
+    return err;
+}
+
+uintptr_t WETS_getEventPayload (uint8_t priority, uint32_t event)
+{
+    ohiassert(event > 0ul);
+    ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    // The dispatched event was taken out of its slot
+    const WETS_Event_t* running = mRunning[priority];
+    if ((running != NULL) && (running->event == event))
+    {
+        return running->payload;
+    }
+
+    WETS_Event_t* e = findEvent(priority,event);
+    return (e != NULL) ? e->payload : 0;
+}
+#endif
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+WETS_Error_t WETS_setOverloadPolicy (uint8_t priority, WETS_Overload_t policy)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(policy <= WETS_OVERLOAD_RETRY);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        mOverloadPolicy[priority] = policy;
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+uint32_t WETS_getOverloadDrops (uint8_t priority)
+{
+    ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    return mOverloadDrops[priority];
+}
+
+uint32_t WETS_getRetryHint (uint8_t priority)
+{
+    ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
+    {
+        if (mEvents[priority].event[i].event == WETS_NO_EVENT)
+        {
+            return 0;
+        }
+    }
+
+    // A slot is released at the next dispatch of this priority, that comes
+    // after the pending events of the higher priorities
+    uint32_t hint = WETS_ISR_PERIOD_ms;
+    for (uint8_t i = 0; i < priority; ++i)
+    {
+        if (mEvents[i].status > 0ul)
+        {
+            hint += WETS_ISR_PERIOD_ms;
+        }
+    }
+    return hint;
+}
+#endif
+
+#if (WETS_USE_CPU_BUDGET == 1)
+WETS_Error_t WETS_setPriorityBudget (uint8_t priority, uint32_t budget, uint32_t period)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(budget <= period);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        mBudgets[priority].budget = budget;
+        mBudgets[priority].period = (budget > 0ul) ? period : 0ul;
+        mBudgets[priority].used   = 0;
+        mBudgetStart[priority]    = mCurrentTime.value;
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_getPriorityBudget (uint8_t priority, WETS_Budget_t* budget)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(budget != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        // Replenish the budget when the period is over
+        isBudgetExhausted(priority);
+        *budget = mBudgets[priority];
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+#endif
+
+bool WETS_isEvent (uint8_t priority, uint32_t event)
+{
+    ohiassert(event > 0ul);
+    ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    return ((mEvents[priority].status & event) > 0ul);
+}
+
+WETS_Error_t WETS_removeEvent (uint8_t priority, uint32_t event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_NO_EVENT_FOUND;
+        uint8_t timer = WETS_NO_TIMER;
+        bool freed = FALSE;
+
+        // The search and the release of the slot are a single critical
+        // section, the slot can't be taken again in between
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (WETS_isEvent(priority,event))
+        {
+            for (uint8_t i = 0; i < WETS_MAX_EVENTS_PER_PRIORITY; ++i)
+            {
+                if ((mEvents[priority].event[i].event != WETS_NO_EVENT) &&
+                   ((mEvents[priority].event[i].event & event) > 0))
+                {
+                    // Clear event...
+                    mEvents[priority].event[i].event = WETS_NO_EVENT;
+                    mEvents[priority].event[i].cb    = NULL;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+                    mEvents[priority].event[i].payload = 0;
+#endif
+                    timer = takeTimer(&mEvents[priority].event[i]);
+
+                    mEvents[priority].status &= ~event;
+                    result = WETS_ERROR_SUCCESS;
+                    freed  = TRUE;
+                    break;
+                }
+            }
+        }
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+        else
+        {
+            uint8_t index = findSpilledEvent(priority,event);
+            if (index < WETS_OVERLOAD_QUEUE_SIZE)
+            {
+                timer = mSpilled[index].timer;
+                deleteSpilledEvent(index);
+                result = WETS_ERROR_SUCCESS;
+            }
+        }
+#endif
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        releaseTimer(timer);
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+        if (freed)
+        {
+            // The released slot can host a spilled event
+            refillEvent(priority);
+        }
+#else
+        (void)freed;
+#endif
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+void WETS_removeAllEvents (void)
+{
+    // Clear all event into the list
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+#if (WETS_USE_DELAY_REARM == 1)
+        uint8_t timers[WETS_MAX_EVENTS_PER_PRIORITY];
+#endif
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        mEvents[i].status = 0ul;
+
+        for (uint8_t j = 0; j < WETS_MAX_EVENTS_PER_PRIORITY; ++j)
+        {
+#if (WETS_USE_DELAY_REARM == 1)
+            timers[j] = takeTimer(&mEvents[i].event[j]);
+#endif
+            mEvents[i].event[j].cb    = NULL;
+            mEvents[i].event[j].event = WETS_NO_EVENT;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+            mEvents[i].event[j].payload = 0;
+#endif
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+#if (WETS_USE_DELAY_REARM == 1)
+        for (uint8_t j = 0; j < WETS_MAX_EVENTS_PER_PRIORITY; ++j)
+        {
+            releaseTimer(timers[j]);
+        }
+#endif
+    }
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+    // The spilled events are taken one by one, to release their timers out
+    // of the critical section
+    for (;;)
+    {
+        uint8_t timer = WETS_NO_TIMER;
+        bool taken = FALSE;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if (mSpilledCount > 0)
+        {
+            mSpilledCount--;
+            timer = mSpilled[mSpilledCount].timer;
+            taken = TRUE;
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+        if (!taken)
+        {
+            break;
+        }
+        releaseTimer(timer);
+    }
+#endif
+}
+
+bool WETS_isAnyEvent (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        if (mEvents[i].status > 0ul) return TRUE;
+    }
+    return FALSE;
+}
+
+/*!
+ * The function moves an event out of its slot, that is released for the
+ * producers before the callback runs. The wait of the event is counted
+ * here, in the critical section that the readers of the statistics take.
+ *
+ * \note It must be called in critical section, in the same one that found
+ *       the event.
+ *
+ * \param[in] priority: The priority group of the event.
+ * \param[in]     slot: The slot of the event.
+ * \param[out]   taken: The copy of the event to be dispatched.
+ */
+static void takeEvent (uint8_t priority, WETS_Event_t* slot, WETS_Event_t* taken)
+{
+    *taken = *slot;
+
+#if (WETS_USE_WAIT_STATISTICS == 1)
+    uint32_t wait = mCurrentTime.value - slot->time;
+    mWaitStatistics[priority].count++;
+    mWaitStatistics[priority].total += wait;
+    if (wait > mWaitStatistics[priority].max)
+    {
+        mWaitStatistics[priority].max = wait;
+    }
+#else
+    (void)priority;
+#endif
+
+    // Delete reference to this event...
+    slot->event       = WETS_NO_EVENT;
+    slot->cb          = NULL;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    slot->payload     = 0;
+#endif
+#if (WETS_USE_DELAY_REARM == 1)
+    slot->timer       = WETS_NO_TIMER;
+#endif
+}
+
+/*!
+ * The function calls the callback of an event taken by \ref takeEvent.
+ *
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The copy of the event to be dispatched.
+ * \param[in]   status: The pending events passed to the callback.
+ * \param[in]    merge: Whether the events returned by the callback are set
+ *                      again into the group.
+ * \return The pending events returned by the callback.
+ */
+static uint32_t runEvent (uint8_t priority,
+                          const WETS_Event_t* event,
+                          uint32_t status,
+                          bool merge)
+{
+#if (WETS_USE_STATISTICS == 1) || (WETS_USE_CPU_BUDGET == 1)
+    uint32_t start = mCurrentTime.value;
+#endif
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+    // The released slot can host a spilled event
+    refillEvent(priority);
+#endif
+
+#if (WETS_USE_DELAY_REARM == 1)
+    // The callback of a delayed event can re-arm its timer
+    if (event->timer != WETS_NO_TIMER)
+    {
+        WETS_enterDelayEvent(event->timer);
+    }
+#endif
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    // The callback reads the payload of the copy, its slot can be reused
+    const WETS_Event_t* previous = mRunning[priority];
+    mRunning[priority] = event;
+#endif
+
+    WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_DISPATCH);
+    status = event->cb(status);
+    WETS_PROFILE_END(WETS_PROFILE_SITE_DISPATCH);
+
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    mRunning[priority] = previous;
+#endif
+#if (WETS_USE_DELAY_REARM == 1)
+    if (event->timer != WETS_NO_TIMER)
+    {
+        WETS_leaveDelayEvent();
+    }
+#endif
+
+#if (WETS_USE_CPU_BUDGET == 1)
+    chargeBudget(priority,mCurrentTime.value - start);
+#endif
+
+    if (merge)
+    {
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        mEvents[priority].status |= status;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+    }
+
+#if (WETS_USE_STATISTICS == 1)
+    WETS_countStatistic(priority,WETS_COUNTER_DISPATCHED);
+    WETS_addStatisticTime(0,mCurrentTime.value - start);
+#endif
+
+#if (WETS_USE_EVENT_CHAIN == 1)
+    // Post the events that depend on this one
+    WETS_resolveEventChains(priority,event->event);
+#endif
+
+    return status;
+}
+
+/*!
+ * The function takes the pending events of a priority group.
+ *
+ * \note It must be called in critical section, in the same one that takes
+ *       the dispatched event.
+ *
+ * \param[in] priority: The priority group.
+ * \return The pending events, that are cleared from the group.
+ */
+static uint32_t takeStatus (uint8_t priority)
+{
+    uint32_t status = mEvents[priority].status;
+    mEvents[priority].status = 0;
+    return status;
+}
+
+#if (WETS_USE_DRAIN_MODE == 0) || (WETS_USE_AGING == 1)
+/*!
+ * The function dispatches a single event.
+ *
+ * \param[in] priority: The priority group of the event.
+ * \param[in]     slot: The slot of the event to be dispatched.
+ */
+static void dispatchEvent (uint8_t priority, WETS_Event_t* slot)
+{
+    WETS_Event_t event;
+    uint32_t status;
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    status = takeStatus(priority);
+    takeEvent(priority,slot,&event);
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+
+    runEvent(priority,&event,status,TRUE);
+}
+#endif
+
+#if (WETS_USE_DRAIN_MODE == 1)
+/*!
+ * The function dispatches all the ready events of a priority group, from
+ * the most important, with a single snapshot of the pending events.
+ * It stops when an event of a higher priority group is set, or when the
+ * number of callbacks is reached.
+ *
+ * \param[in]  priority: The priority group.
+ * \param[in] maxEvents: The maximum number of callbacks to call.
+ * \return The number of called callbacks.
+ */
+static uint16_t drainEvents (uint8_t priority, uint16_t maxEvents)
+{
+    uint32_t status;
+    uint32_t done = 0ul;
+    uint16_t count = 0;
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    status = takeStatus(priority);
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+
+    for (;;)
+    {
+        uint32_t ready = status & ~done;
+        WETS_Event_t event;
+        bool found = FALSE;
+
+        // Search the most important ready event
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        while ((ready > 0ul) && !found)
+        {
+            uint32_t bit = 0x80000000ul >> __builtin_clz(ready);
+            WETS_Event_t* slot = findEvent(priority,bit);
+            if (slot != NULL)
+            {
+                takeEvent(priority,slot,&event);
+                found = TRUE;
+            }
+            done  |= bit;
+            ready &= ~bit;
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        if (!found)
+        {
+            break;
+        }
+
+        status = runEvent(priority,&event,status,FALSE);
+
+        // The remaining events wait for the next call
+        if (++count >= maxEvents)
+        {
+            break;
+        }
+
+        // Check whether a higher priority needs the CPU, a group out of
+        // budget can't take it
+        bool preempted = FALSE;
+        for (uint8_t i = 0; i < priority; ++i)
+        {
+            if (isReady(i))
+            {
+                preempted = TRUE;
+                break;
+            }
+        }
+        if (preempted)
+        {
+            break;
+        }
+#if (WETS_USE_CPU_BUDGET == 1)
+        // The remaining events wait for the next period
+        if (isBudgetExhausted(priority))
+        {
+            break;
+        }
+#endif
+    }
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    mEvents[priority].status |= status;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+    return count;
+}
+#endif
+
+void WETS_init (void)
+{
+    WETS_removeAllEvents();
+    WETS_removeAllDelayEvents();
+    WETS_removeAllCyclicEvents();
+#if (WETS_USE_POST_QUEUE == 1)
+    WETS_removeAllPostedEvents();
+#endif
+#if (WETS_USE_OFFLOAD == 1)
+    WETS_removeAllOffloadEvents();
+#endif
+#if (WETS_USE_EVENT_CHAIN == 1)
+    WETS_removeAllEventChains();
+#endif
+#if (WETS_USE_EVENT_GROUP == 1)
+    WETS_removeAllEventGroups();
+#endif
+#if (WETS_USE_EVENT_ID == 1)
+    WETS_removeAllEventIds();
+#endif
+#if (WETS_USE_STATE_MACHINE == 1)
+    WETS_removeAllStateMachines();
+#endif
+#if (WETS_USE_AGING == 1)
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mAgingThreshold[i] = WETS_AGING_THRESHOLD_ms;
+    }
+    mAgingTime = mCurrentTime.value;
+#endif
+#if (WETS_USE_WAIT_STATISTICS == 1)
+    WETS_clearWaitStatistics();
+#endif
+#if (WETS_USE_STATISTICS == 1)
+    WETS_clearStatistics();
+#endif
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mOverloadPolicy[i] = WETS_OVERLOAD_DROP_NEWEST;
+        mOverloadDrops[i]  = 0;
+    }
+#endif
+#if (WETS_USE_CPU_BUDGET == 1)
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mBudgets[i].budget    = 0;
+        mBudgets[i].period    = 0;
+        mBudgets[i].used      = 0;
+        mBudgets[i].throttled = 0;
+        mBudgetStart[i]       = mCurrentTime.value;
+    }
+#endif
+#if (WETS_USE_IO_SOURCES == 1)
+    WETS_removeAllIoSources();
+#endif
+#if (WETS_USE_IPC == 1)
+    WETS_removeAllIpcEvents();
+#endif
+#if (WETS_USE_PROFILING == 1) && (WETS_PROFILE_USE_REFERENCE == 1)
+    WETS_clearProfiles();
+#endif
+}
+
+/*!
+ * The function updates the delayed and cyclic events when the timer
+ * interrupt has been asserted.
+ */
+static void updateTimers (void)
+{
+    if (mIsTimerFired.value)
+    {
+        // Clear first, a tick asserted during the update is not lost
+        mIsTimerFired.value = FALSE;
+
+        WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_UPDATE_DELAY);
+        WETS_updateDelayEvents();
+        WETS_PROFILE_END(WETS_PROFILE_SITE_UPDATE_DELAY);
+
+        WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_UPDATE_CYCLIC);
+        WETS_updateCyclicEvents();
+        WETS_PROFILE_END(WETS_PROFILE_SITE_UPDATE_CYCLIC);
+    }
+}
+
+/*!
+ * The function dispatches the most important event of the highest priority
+ * group, or the oldest promoted event when the aging is enabled. With the
+ * drain mode, it dispatches the ready events of the group in one pass.
+ *
+ * \param[in] maxEvents: The maximum number of callbacks to call.
+ * \return The number of called callbacks, 0 when no event is ready.
+ */
+static uint16_t dispatchNextEvent (uint16_t maxEvents)
+{
+#if (WETS_USE_AGING == 1)
+    // The events can age only when the time changes
+    if (mAgingTime != mCurrentTime.value)
+    {
+        uint8_t priority = WETS_NO_PRIORITY;
+        WETS_Event_t* event = findAgedEvent(&priority);
+        if (event != NULL)
+        {
+#if (WETS_USE_WAIT_STATISTICS == 1)
+            mWaitStatistics[priority].promoted++;
+#endif
+            dispatchEvent(priority,event);
+            return 1;
+        }
+        mAgingTime = mCurrentTime.value;
+    }
+#endif
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        // The groups without budget are skipped until the replenishment
+        if (isReady(i))
+        {
+            WETS_Event_t* event = findMostImportantEvent(i);
+            if (event != NULL)
+            {
+#if (WETS_USE_DRAIN_MODE == 1)
+                (void)event;
+                return drainEvents(i,maxEvents);
+#else
+                (void)maxEvents;
+                dispatchEvent(i,event);
+                return 1;
+#endif
+            }
+        }
+    }
+    return 0;
+}
+
+#if (WETS_USE_SNAPSHOT == 1)
+uint8_t WETS_saveEvents (WETS_SnapshotEntry_t* entries, uint8_t size)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        for (uint8_t j = 0; (j < WETS_MAX_EVENTS_PER_PRIORITY) && (count < size); ++j)
+        {
+            WETS_Event_t* event = &mEvents[i].event[j];
+            if ((event->event == WETS_NO_EVENT) || ((mEvents[i].status & event->event) == 0ul))
+            {
+                continue;
+            }
+
+            entries[count].cb        = event->cb;
+            entries[count].event     = event->event;
+            entries[count].remaining = 0;
+            entries[count].period    = 0;
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+            entries[count].payload   = event->payload;
+#else
+            entries[count].payload   = 0;
+#endif
+            entries[count].priority  = i;
+            count++;
+        }
+    }
+    return count;
+}
+
+void WETS_restoreCurrentTime (uint32_t time)
+{
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    mCurrentTime.value = time;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+}
+#endif
+
+#if (WETS_USE_PRIORITY_THREADS == 1)
+bool WETS_dispatchPriorityEvent (uint8_t priority)
+{
+    WETS_Event_t event;
+    uint32_t status = 0;
+
+    // The producers of the other threads change the slots and the status
+    // word: the event is copied out of its slot with the status, and the
+    // copy is dispatched
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    WETS_Event_t* slot = findMostImportantEvent(priority);
+    if (slot != NULL)
+    {
+        status = takeStatus(priority);
+        takeEvent(priority,slot,&event);
+    }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+
+    if (slot == NULL)
+    {
+        return FALSE;
+    }
+    runEvent(priority,&event,status,TRUE);
+    return TRUE;
+}
+#endif
+
+uint32_t WETS_poll (uint16_t maxEvents, uint32_t maxTime)
+{
+    uint32_t start = mCurrentTime.value;
+
+    updateTimers();
+
+#if (WETS_USE_POST_QUEUE == 1)
+    // Move the events posted by other threads into the tables
+    WETS_drainPostedEvents();
+#endif
+#if (WETS_USE_IPC == 1)
+    // Move the events sent by other processes into the tables
+    WETS_drainIpcEvents();
+#endif
+
+    uint16_t count = 0;
+    while (count < maxEvents)
+    {
+        if ((maxTime != WETS_NO_TIMEOUT) && ((mCurrentTime.value - start) >= maxTime))
+        {
+            break;
+        }
+
+        // Each dispatch starts again from the highest priority
+        uint16_t dispatched = dispatchNextEvent(maxEvents - count);
+        if (dispatched == 0)
+        {
+            break;
+        }
+        count += dispatched;
+    }
+
+    if (isAnyReadyEvent() || mIsTimerFired.value)
+    {
+        return 0;
+    }
+    return WETS_getNextTimeout();
+}
+
+void WETS_loop (void)
+{
+    for (;;)
+    {
+#if (WETS_USE_LOW_POWER_MODE == 1)
+        bool lowPowerMode = TRUE;
+#endif
+
+        // One event for each iteration
+        WETS_poll(WETS_LOOP_EVENTS,WETS_NO_TIMEOUT);
+
+#if (WETS_USE_STATISTICS == 1)
+        uint32_t idleStart = mCurrentTime.value;
+#endif
+        while (!isAnyReadyEvent())
+        {
+#if (WETS_USE_IO_SOURCES == 1)
+            uint8_t ready = 0;
+#endif
+#if (WETS_USE_POST_QUEUE == 1) || (WETS_USE_IPC == 1)
+            uint16_t posted = 0;
+#endif
+
+            WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_BEFORE_SLEEP);
+            WETS_doBeforeSleep();
+            WETS_PROFILE_END(WETS_PROFILE_SITE_BEFORE_SLEEP);
+#if (WETS_USE_IO_SOURCES == 1)
+            // Sleep until a descriptor is ready or the next timer expires
+            ready = WETS_waitIoSources(mIsTimerFired.value ? 0 : WETS_getNextTimeout());
+#else
+            // TODO: go to sleep!
+#endif
+            WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_AFTER_WAKEUP);
+            WETS_doAfterWakeUp();
+            WETS_PROFILE_END(WETS_PROFILE_SITE_AFTER_WAKEUP);
+
+//#if (WETS_USE_LOW_POWER_MODE == 1)
+//        if (lowPowerMode)
+//        {
+//            // TODO: call low power mode enable function!
+//        }
+//#endif
+
+#if (WETS_USE_STATISTICS == 1)
+            bool ticked  = mIsTimerFired.value;
+            bool pending = isAnyReadyEvent();
+#endif
+
+            updateTimers();
+
+#if (WETS_USE_POST_QUEUE == 1)
+            posted = WETS_drainPostedEvents();
+#endif
+#if (WETS_USE_IPC == 1)
+            // The events of the other processes count as posted ones
+            posted += WETS_drainIpcEvents();
+#endif
+
+#if (WETS_USE_STATISTICS == 1)
+            // Save the cause of the wake-up
+            WETS_Wakeup_t cause = WETS_WAKEUP_UNKNOWN;
+#if (WETS_USE_IO_SOURCES == 1)
+            if (ready > 0)
+            {
+                cause = WETS_WAKEUP_IO;
+            }
+            else
+#endif
+            if (pending)
+            {
+                cause = WETS_WAKEUP_EVENT;
+            }
+#if (WETS_USE_POST_QUEUE == 1) || (WETS_USE_IPC == 1)
+            else if (posted > 0)
+            {
+                cause = WETS_WAKEUP_POSTED;
+            }
+#endif
+            else if (ticked)
+            {
+                cause = isAnyReadyEvent() ? WETS_WAKEUP_TIMER : WETS_WAKEUP_TICK;
+            }
+            WETS_countWakeup(cause);
+#else
+#if (WETS_USE_IO_SOURCES == 1)
+            (void)ready;
+#endif
+#if (WETS_USE_POST_QUEUE == 1) || (WETS_USE_IPC == 1)
+            (void)posted;
+#endif
+#endif
+        }
+#if (WETS_USE_STATISTICS == 1)
+        WETS_addStatisticTime(mCurrentTime.value - idleStart,0);
+#endif
+    }
+}
+
+void WETS_timerIsrCallback (void * unused)
+{
+    WETS_PROFILE_BEGIN(WETS_PROFILE_SITE_TIMER_ISR);
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    mCurrentTime.value += WETS_ISR_PERIOD_ms;
+    mIsTimerFired.value = TRUE;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+    WETS_PROFILE_END(WETS_PROFILE_SITE_TIMER_ISR);
+}
+
+uint32_t WETS_getCurrentTime (void)
+{
+    return mCurrentTime.value;
+}
+
+uint32_t WETS_getNextTimeout (void)
 {
-    return mCurrentTime;
+    uint32_t delay  = WETS_getNextDelayEventTimeout();
+    uint32_t cyclic = WETS_getNextCyclicEventTimeout();
+    uint32_t next   = (delay < cyclic) ? delay : cyclic;
+
+#if (WETS_USE_CPU_BUDGET == 1)
+    uint32_t budget = getNextBudgetTimeout();
+    next = (budget < next) ? budget : next;
+#endif
+    return next;
 }
 
 _weak void WETS_doBeforeSleep (void)
@@ -50,6 +50,177 @@ extern "C"
  */
 WETS_Error_t WETS_addEvent (pEventCallback cb, uint8_t priority, uint32_t event);
 
+#if (WETS_USE_DELAY_REARM == 1) || (WETS_USE_RECORDER == 1)
+/*!
+ * This function adds the event of an expired timer. A delayed timer is kept
+ * until the dispatch of the event, see \ref WETS_rearmDelayEvent, and the
+ * event is not recorded, see \ref WETS_Recorder.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]    timer: The index of the fired delayed timer, or
+ *                      \ref WETS_NO_TIMER.
+ * \return The same values of \ref WETS_addEvent, but
+ *         \ref WETS_ERROR_SUCCESS means that the event took the timer, also
+ *         when it was merged with a pending one.
+ */
+WETS_Error_t WETS_addTimerEvent (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint8_t timer);
+#endif
+
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+/*!
+ * This function adds an event like \ref WETS_addEvent, attaching a user value
+ * to it. The value can be read by the callback with
+ * \ref WETS_getEventPayload. When the event is already set, the payload is
+ * replaced with the new one.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event.
+ * \return The same values of \ref WETS_addEvent.
+ */
+WETS_Error_t WETS_addPayloadEvent (pEventCallback cb,
+                                   uint8_t priority,
+                                   uint32_t event,
+                                   uintptr_t payload);
+
+/*!
+ * This function returns the value attached to a pending event. Called by
+ * the callback of the event, it returns the payload of the dispatched event,
+ * also when the same event was posted again in the meanwhile.
+ *
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be searched.
+ * \return The payload of the event, 0 when the event is not set.
+ */
+uintptr_t WETS_getEventPayload (uint8_t priority, uint32_t event);
+#endif
+
+#if (WETS_USE_OVERLOAD_POLICY == 1)
+/*!
+ * The size of the overflow queue shared by the priorities with the
+ * \ref WETS_OVERLOAD_SPILL policy.
+ */
+#if !defined (WETS_OVERLOAD_QUEUE_SIZE)
+#define WETS_OVERLOAD_QUEUE_SIZE                 16u
+#endif
+
+/*!
+ * The policies applied when an event is added to a priority group without
+ * free slots.
+ */
+typedef enum _WETS_Overload
+{
+    /*!< The new event is dropped, the default behaviour. */
+    WETS_OVERLOAD_DROP_NEWEST = 0,
+    /*!< The least important pending event is dropped when the new one is
+         more important, otherwise the new one is dropped. */
+    WETS_OVERLOAD_DROP_LOWEST,
+    /*!< The new event waits into the overflow queue, and it is moved into
+         the group as soon as a slot is released. */
+    WETS_OVERLOAD_SPILL,
+    /*!< The new event is refused with \ref WETS_ERROR_EVENT_RETRY, the
+         caller keeps it and tries again, see \ref WETS_getRetryHint. */
+    WETS_OVERLOAD_RETRY,
+
+} WETS_Overload_t;
+
+/*!
+ * This function changes the overload policy of a priority group.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]   policy: The new policy.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the policy was changed.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_setOverloadPolicy (uint8_t priority, WETS_Overload_t policy);
+
+/*!
+ * This function returns the number of events lost by a priority group since
+ * \ref WETS_init.
+ *
+ * \param[in] priority: The priority group.
+ * \return The number of dropped events.
+ */
+uint32_t WETS_getOverloadDrops (uint8_t priority);
+
+/*!
+ * This function suggests how long a caller refused with
+ * \ref WETS_ERROR_EVENT_RETRY should wait before adding again the event.
+ * The estimate grows with the number of higher priorities that have pending
+ * events, since they are dispatched first.
+ *
+ * \param[in] priority: The priority group.
+ * \return The time in milli-second, 0 when a slot is already free.
+ */
+uint32_t WETS_getRetryHint (uint8_t priority);
+#endif
+
+#if (WETS_USE_CPU_BUDGET == 1)
+/*!
+ * The CPU budget of a priority group.
+ */
+typedef struct _WETS_Budget
+{
+    /*!< The time in milli-second that the group can use into each period. */
+    uint32_t budget;
+
+    /*!< The replenishment period in milli-second, 0 when the group has no
+         budget. */
+    uint32_t period;
+
+    /*!< The time in milli-second used into the current period. */
+    uint32_t used;
+
+    /*!< The number of periods where the group spent the whole budget. */
+    uint32_t throttled;
+
+} WETS_Budget_t;
+
+/*!
+ * This function limits the CPU time of a priority group: its callbacks can
+ * run at most for budget milli-second into each period. When the budget is
+ * spent, the pending events of the group wait for the next period, while
+ * the other groups are still dispatched.
+ *
+ * \note The time of a callback is measured on the scheduler time base, so
+ *       a callback shorter than a tick is charged only when a tick happens
+ *       during its execution: the charge is exact on average.
+ * \note A callback is never interrupted, the group can exceed its budget by
+ *       the length of the last callback.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]   budget: The time in milli-second, 0 to remove the limit.
+ * \param[in]   period: The replenishment period in milli-second.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the budget was changed.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_setPriorityBudget (uint8_t priority, uint32_t budget, uint32_t period);
+
+/*!
+ * This function returns the budget usage of a priority group.
+ *
+ * \param[in]  priority: The priority group.
+ * \param[out]   budget: The budget usage.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the usage was copied.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_getPriorityBudget (uint8_t priority, WETS_Budget_t* budget);
+#endif
+
 /*!
  * TODO
  */
@@ -65,6 +236,41 @@ bool WETS_isEvent (uint8_t priority, uint32_t event);
  */
 void WETS_removeAllEvents (void);
 
+#if (WETS_USE_SNAPSHOT == 1)
+/*!
+ * This function copies the pending events, for \ref WETS_snapshot.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[out] entries: The array to be filled.
+ * \param[in]     size: The size of the array.
+ * \return The number of copied events.
+ */
+uint8_t WETS_saveEvents (WETS_SnapshotEntry_t* entries, uint8_t size);
+
+/*!
+ * This function changes the time base, for \ref WETS_restore.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] time: The new time in milli-second.
+ */
+void WETS_restoreCurrentTime (uint32_t time);
+#endif
+
+#if (WETS_USE_PRIORITY_THREADS == 1)
+/*!
+ * This function dispatches the most important pending event of a priority
+ * group. It is called by the thread of the group.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] priority: The priority group.
+ * \return TRUE when an event was dispatched, FALSE otherwise.
+ */
+bool WETS_dispatchPriorityEvent (uint8_t priority);
+#endif
+
 /*!
  * \}
  */
@@ -79,6 +285,28 @@ void WETS_init (void);
 
 void WETS_loop (void);
 
+/*!
+ * This function runs one step of the scheduler without blocking, so that it
+ * can be embedded into an external event loop (libuv, epoll, game tick...).
+ * It updates the expired timers, then dispatches the ready events, each time
+ * from the highest priority, until the budget is spent or no event is left.
+ *
+ * \note The time base is still advanced by \ref WETS_timerIsrCallback.
+ * \note With \ref WETS_USE_DRAIN_MODE, each pass over a group counts all
+ *       its callbacks and stops when maxEvents is reached: the remaining
+ *       events of the group are dispatched by the next call. The time
+ *       budget is checked only between two passes.
+ *
+ * \param[in] maxEvents: The maximum number of callbacks to call.
+ * \param[in]   maxTime: The time budget in milli-second, measured on the
+ *                       scheduler time base, or \ref WETS_NO_TIMEOUT for no
+ *                       limit.
+ * \return The time in milli-second that the host can sleep before calling
+ *         again the function: 0 when events are still pending, or
+ *         \ref WETS_NO_TIMEOUT when there isn't any timer.
+ */
+uint32_t WETS_poll (uint16_t maxEvents, uint32_t maxTime);
+
 /*!
  * The callback for the timer that manage WETS scheduler.
  *
@@ -89,6 +317,75 @@ void WETS_timerIsrCallback (void * unused);
 
 uint32_t WETS_getCurrentTime (void);
 
+/*!
+ * This function returns the time until the first delayed or cyclic event
+ * expires, or until a priority group with pending events gets back its CPU
+ * budget.
+ *
+ * \return The time in milli-second, 0 when a timer is already expired, or
+ *         \ref WETS_NO_TIMEOUT when there isn't any timer.
+ */
+uint32_t WETS_getNextTimeout (void);
+
+#if (WETS_USE_AGING == 1)
+/*!
+ * This function change the aging threshold of a priority group.
+ * A pending event of this priority that waits more than the threshold is
+ * promoted: it is dispatched before any event of the higher priorities.
+ * The wait of an event is bounded by the threshold plus the length of the
+ * callbacks already running or promoted before it.
+ *
+ * \param[in]  priority: The priority group.
+ * \param[in] threshold: The threshold in milli-second, 0 to disable the
+ *                       aging of the priority.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the threshold was changed.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_setAgingThreshold (uint8_t priority, uint32_t threshold);
+#endif
+
+#if (WETS_USE_WAIT_STATISTICS == 1)
+/*!
+ * The wait-time metrics of a priority group.
+ */
+typedef struct _WETS_WaitStatistics
+{
+    /*!< The number of dispatched events. */
+    uint32_t count;
+
+    /*!< The sum of the waits, in milli-second, of the dispatched events. */
+    uint32_t total;
+
+    /*!< The longest wait, in milli-second. */
+    uint32_t max;
+
+    /*!< The number of events dispatched by aging. */
+    uint32_t promoted;
+
+} WETS_WaitStatistics_t;
+
+/*!
+ * This function returns the wait-time metrics of a priority group: the
+ * wait of an event is the time between its post and its dispatch.
+ *
+ * \param[in]  priority: The priority group.
+ * \param[out] statistics: The metrics of the priority.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the metrics were copied.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_getWaitStatistics (uint8_t priority,
+                                     WETS_WaitStatistics_t* statistics);
+
+/*!
+ * This function clear the wait-time metrics of all priority groups.
+ */
+void WETS_clearWaitStatistics (void);
+#endif
+
 void WETS_doBeforeSleep (void);
 
 void WETS_doAfterWakeUp (void);
@@ -0,0 +1,480 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-fsm.c
+ * \brief
+ */
+
+#include "wets-fsm.h"
+#include "wets-event.h"
+#include "wets-delay.h"
+
+#if (WETS_USE_STATE_MACHINE == 1)
+
+#if (WETS_MAX_PRIORITY_LEVEL > 8)
+#error "WETS_USE_STATE_MACHINE supports up to 8 priority levels"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_StateMachine
+ * \{
+ */
+
+/*!
+ * The running machines.
+ */
+static WETS_StateMachine_t* mMachines[WETS_MAX_STATE_MACHINES];
+
+/*!
+ * The machine bound to each event of each priority group,
+ * \ref WETS_MAX_STATE_MACHINES for the free events.
+ */
+static uint8_t mOwners[WETS_MAX_PRIORITY_LEVEL][32];
+
+/*!
+ * The events of each group that were removed by the current dispatch, they
+ * are cleared from the returned status.
+ */
+static uint32_t mCancelled[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The function checks whether a state is a parent of another one.
+ *
+ * \param[in] states: The states of the machine.
+ * \param[in] parent: The parent state.
+ * \param[in]  state: The child state.
+ * \return TRUE when parent is a parent of state, FALSE otherwise.
+ */
+static bool isParent (const WETS_State_t* states, uint8_t parent, uint8_t state)
+{
+    for (uint8_t s = states[state].parent; s != WETS_NO_STATE; s = states[s].parent)
+    {
+        if (s == parent)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*!
+ * The function checks the states of a table: the parents and the initial
+ * children are states of the table, the initial child of a state is one of
+ * its children, and no state is nested deeper than
+ * \ref WETS_MAX_STATE_DEPTH, that rejects also the loops of parents.
+ *
+ * \param[in] table: The description of the machine.
+ * \return TRUE when the states are valid, FALSE otherwise.
+ */
+static bool isStateTableValid (const WETS_StateMachineTable_t* table)
+{
+    const WETS_State_t* states = table->states;
+
+    for (uint8_t i = 0; i < table->stateCount; ++i)
+    {
+        if ((states[i].parent != WETS_NO_STATE) && (states[i].parent >= table->stateCount))
+        {
+            return FALSE;
+        }
+        if ((states[i].initial != WETS_NO_STATE) &&
+            ((states[i].initial >= table->stateCount) || (states[states[i].initial].parent != i)))
+        {
+            return FALSE;
+        }
+    }
+
+    // The parents are valid, the paths to the top can be walked
+    for (uint8_t i = 0; i < table->stateCount; ++i)
+    {
+        uint8_t depth = 0;
+        for (uint8_t s = i; s != WETS_NO_STATE; s = states[s].parent)
+        {
+            if (++depth > WETS_MAX_STATE_DEPTH)
+            {
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/*!
+ * The function cancels the timeout of the machine.
+ */
+static void cancelTimeout (WETS_StateMachine_t* machine)
+{
+    uint32_t timeout = machine->table->timeout;
+
+    WETS_removeDelayEvent(machine->priority,timeout);
+    WETS_removeEvent(machine->priority,timeout);
+    mCancelled[machine->priority] |= timeout;
+}
+
+/*!
+ * The function enters a state: the entry action is called and its timeout
+ * is armed.
+ */
+static void enterState (WETS_StateMachine_t* machine, uint8_t state, uint32_t event);
+
+/*!
+ * The function leaves a state: the exit action is called and its timeout is
+ * cancelled.
+ */
+static void exitState (WETS_StateMachine_t* machine, uint8_t state, uint32_t event)
+{
+    const WETS_State_t* s = &machine->table->states[state];
+
+    if (s->exit != NULL)
+    {
+        s->exit(machine,event);
+    }
+    if ((s->timeout > 0) && (machine->table->timeout > 0ul))
+    {
+        cancelTimeout(machine);
+    }
+}
+
+static void enterState (WETS_StateMachine_t* machine, uint8_t state, uint32_t event)
+{
+    const WETS_State_t* s = &machine->table->states[state];
+
+    if ((s->timeout > 0) && (machine->table->timeout > 0ul))
+    {
+        cancelTimeout(machine);
+        WETS_postDelayStateEvent(machine,machine->table->timeout,s->timeout);
+    }
+    if (s->entry != NULL)
+    {
+        s->entry(machine,event);
+    }
+}
+
+/*!
+ * The function enters the states from a parent, not entered, to a target,
+ * then the initial children of the target.
+ *
+ * \param[in] machine: The machine.
+ * \param[in]  parent: The parent, \ref WETS_NO_STATE for the top.
+ * \param[in]  target: The target state.
+ * \param[in]   event: The event of the transition.
+ */
+static void enterStates (WETS_StateMachine_t* machine,
+                         uint8_t parent,
+                         uint8_t target,
+                         uint32_t event)
+{
+    const WETS_State_t* states = machine->table->states;
+    uint8_t path[WETS_MAX_STATE_DEPTH];
+    uint8_t depth = 0;
+
+    // The states are entered from the outer one
+    for (uint8_t s = target; (s != parent) && (depth < WETS_MAX_STATE_DEPTH); s = states[s].parent)
+    {
+        path[depth++] = s;
+    }
+    // The depth is checked by WETS_startStateMachine()
+    ohiassert((depth < WETS_MAX_STATE_DEPTH) || (states[path[depth - 1]].parent == parent));
+    while (depth > 0)
+    {
+        enterState(machine,path[--depth],event);
+    }
+
+    while (states[target].initial != WETS_NO_STATE)
+    {
+        target = states[target].initial;
+        enterState(machine,target,event);
+    }
+    machine->state = target;
+}
+
+/*!
+ * The function runs the transition of an input event.
+ *
+ * \param[in] machine: The machine.
+ * \param[in]   event: The input event.
+ */
+static void handleEvent (WETS_StateMachine_t* machine, uint32_t event)
+{
+    const WETS_StateMachineTable_t* table = machine->table;
+    const WETS_State_t* states = table->states;
+    const WETS_Transition_t* transition = NULL;
+
+    // The column of the event is its position into the mask
+    uint8_t column = (uint8_t)__builtin_popcount(table->events & (event - 1ul));
+    uint8_t columns = (uint8_t)__builtin_popcount(table->events);
+
+    // The current state, then its parents, can handle the event
+    uint8_t source = machine->state;
+    while (source != WETS_NO_STATE)
+    {
+        transition = &table->transitions[(source * columns) + column];
+        if (transition->target != WETS_NO_STATE)
+        {
+            break;
+        }
+        source = states[source].parent;
+    }
+
+    if (source == WETS_NO_STATE)
+    {
+        return;
+    }
+
+    if (transition->target == WETS_INTERNAL_STATE)
+    {
+        if (transition->action != NULL)
+        {
+            transition->action(machine,event);
+        }
+        return;
+    }
+
+    // The states are left up to the nearest parent of the source that
+    // contains the target: a transition to the source itself leaves it
+    uint8_t target = transition->target;
+    uint8_t common = source;
+    while ((common != WETS_NO_STATE) && !isParent(states,common,target))
+    {
+        common = states[common].parent;
+    }
+
+    for (uint8_t s = machine->state; s != common; s = states[s].parent)
+    {
+        exitState(machine,s,event);
+    }
+
+    if (transition->action != NULL)
+    {
+        transition->action(machine,event);
+    }
+
+    enterStates(machine,common,target,event);
+}
+
+/*!
+ * The function dispatches the most important event of a status word to its
+ * machine.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]   status: The status word of the group.
+ * \return The status without the handled event.
+ */
+static uint32_t dispatchStateEvent (uint8_t priority, uint32_t status)
+{
+    if (status == 0ul)
+    {
+        return 0ul;
+    }
+
+    uint8_t bit = (uint8_t)(31u - __builtin_clz(status));
+    uint32_t event = (1ul << bit);
+    uint8_t machine = mOwners[priority][bit];
+
+    mCancelled[priority] = 0ul;
+    if (machine < WETS_MAX_STATE_MACHINES)
+    {
+        handleEvent(mMachines[machine],event);
+    }
+    return status & ~(event | mCancelled[priority]);
+}
+
+/*!
+ * The callbacks of the input events, one for each priority group.
+ */
+#define WETS_FSM_CALLBACK(n)                                       \
+    static uint32_t dispatchStateEvent##n (uint32_t status)         \
+    {                                                               \
+        return dispatchStateEvent(n,status);                        \
+    }
+
+WETS_FSM_CALLBACK(0)
+WETS_FSM_CALLBACK(1)
+WETS_FSM_CALLBACK(2)
+WETS_FSM_CALLBACK(3)
+WETS_FSM_CALLBACK(4)
+WETS_FSM_CALLBACK(5)
+WETS_FSM_CALLBACK(6)
+WETS_FSM_CALLBACK(7)
+
+static const pEventCallback mCallbacks[8] =
+{
+    dispatchStateEvent0, dispatchStateEvent1, dispatchStateEvent2, dispatchStateEvent3,
+    dispatchStateEvent4, dispatchStateEvent5, dispatchStateEvent6, dispatchStateEvent7,
+};
+
+WETS_Error_t WETS_startStateMachine (WETS_StateMachine_t* machine,
+                                     const WETS_StateMachineTable_t* table,
+                                     uint8_t priority,
+                                     void* context)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(machine != NULL);
+    err |= ohiassert(table != NULL);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        err |= ohiassert(table->events > 0ul);
+        err |= ohiassert((table->timeout & ~table->events) == 0ul);
+        err |= ohiassert(table->initial < table->stateCount);
+        err |= ohiassert(table->states != NULL);
+    }
+    if (err == ERRORS_NO_ERROR)
+    {
+        err |= ohiassert(isStateTableValid(table));
+    }
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        uint8_t index = WETS_MAX_STATE_MACHINES;
+        for (uint8_t i = 0; i < WETS_MAX_STATE_MACHINES; ++i)
+        {
+            if (mMachines[i] == machine)
+            {
+                return WETS_ERROR_FSM_EVENT_USED;
+            }
+            if ((mMachines[i] == NULL) && (index == WETS_MAX_STATE_MACHINES))
+            {
+                index = i;
+            }
+        }
+        if (index == WETS_MAX_STATE_MACHINES)
+        {
+            return WETS_ERROR_NO_FSM_AVAILABLE;
+        }
+
+        for (uint8_t bit = 0; bit < 32u; ++bit)
+        {
+            if (((table->events & (1ul << bit)) > 0ul) &&
+                (mOwners[priority][bit] < WETS_MAX_STATE_MACHINES))
+            {
+                return WETS_ERROR_FSM_EVENT_USED;
+            }
+        }
+
+        machine->table    = table;
+        machine->priority = priority;
+        machine->context  = context;
+        machine->state    = WETS_NO_STATE;
+
+        mMachines[index] = machine;
+        for (uint8_t bit = 0; bit < 32u; ++bit)
+        {
+            if ((table->events & (1ul << bit)) > 0ul)
+            {
+                mOwners[priority][bit] = index;
+            }
+        }
+
+        enterStates(machine,WETS_NO_STATE,table->initial,0ul);
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_stopStateMachine (WETS_StateMachine_t* machine)
+{
+    for (uint8_t i = 0; i < WETS_MAX_STATE_MACHINES; ++i)
+    {
+        if ((machine != NULL) && (mMachines[i] == machine))
+        {
+            for (uint8_t bit = 0; bit < 32u; ++bit)
+            {
+                if (mOwners[machine->priority][bit] == i)
+                {
+                    mOwners[machine->priority][bit] = WETS_MAX_STATE_MACHINES;
+                    WETS_removeDelayEvent(machine->priority,(1ul << bit));
+                    WETS_removeEvent(machine->priority,(1ul << bit));
+                }
+            }
+            mMachines[i] = NULL;
+            return WETS_ERROR_SUCCESS;
+        }
+    }
+    return WETS_ERROR_NO_FSM_FOUND;
+}
+
+void WETS_removeAllStateMachines (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_STATE_MACHINES; ++i)
+    {
+        mMachines[i] = NULL;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        for (uint8_t bit = 0; bit < 32u; ++bit)
+        {
+            mOwners[i][bit] = WETS_MAX_STATE_MACHINES;
+        }
+    }
+}
+
+WETS_Error_t WETS_postStateEvent (WETS_StateMachine_t* machine, uint32_t event)
+{
+    if ((machine == NULL) || ((machine->table->events & event) != event))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+    return WETS_addEvent(mCallbacks[machine->priority],machine->priority,event);
+}
+
+WETS_Error_t WETS_postDelayStateEvent (WETS_StateMachine_t* machine,
+                                       uint32_t event,
+                                       uint32_t timeout)
+{
+    if ((machine == NULL) || ((machine->table->events & event) != event))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+    return WETS_addDelayEvent(mCallbacks[machine->priority],machine->priority,event,timeout);
+}
+
+bool WETS_isInState (const WETS_StateMachine_t* machine, uint8_t state)
+{
+    if ((machine == NULL) || (state >= machine->table->stateCount))
+    {
+        return FALSE;
+    }
+    return (machine->state == state) || isParent(machine->table->states,state,machine->state);
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_STATE_MACHINE
@@ -0,0 +1,249 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-fsm.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_FSM_H
+#define __WARCOMEB_WETS_FSM_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_StateMachine WETS State Machines Management
+ * \ingroup  WETS
+ * \{
+ *
+ * A state machine is described by constant tables: the states, with their
+ * parent, entry and exit actions and timeout, and the transitions, with one
+ * row for each state and one column for each input event. The inputs are
+ * events of a priority group, so the machine is driven by the scheduler:
+ * the transition is found by indexing the table, and when a state doesn't
+ * handle an event, its parent is tried.
+ *
+ * The timeout of a state is a delayed event armed on entry and cancelled on
+ * exit. A machine has a single timeout event, so the timeout of a nested
+ * state replaces the one of its parents.
+ */
+
+#if !defined (WETS_MAX_STATE_MACHINES)
+#define WETS_MAX_STATE_MACHINES                  4u
+#endif
+
+/*!
+ * The maximum nesting of the states.
+ */
+#if !defined (WETS_MAX_STATE_DEPTH)
+#define WETS_MAX_STATE_DEPTH                     8u
+#endif
+
+/*!
+ * No state: a top state has no parent, a leaf state has no initial child,
+ * and a transition to no state lets the parent handle the event.
+ */
+#define WETS_NO_STATE                            0xFFu
+
+/*!
+ * The target of an internal transition: the action is called, without
+ * leaving the current state.
+ */
+#define WETS_INTERNAL_STATE                      0xFEu
+
+typedef struct _WETS_StateMachine WETS_StateMachine_t;
+
+/*!
+ * Function pointer type for the actions.
+ */
+typedef void (*pStateAction)(WETS_StateMachine_t* machine, uint32_t event);
+
+/*!
+ * A state.
+ */
+typedef struct _WETS_State
+{
+    /*!< The parent state, \ref WETS_NO_STATE for a top state. */
+    uint8_t parent;
+
+    /*!< The child entered with this state, \ref WETS_NO_STATE for a leaf. */
+    uint8_t initial;
+
+    /*!< The timeout in milli-second, 0 for no timeout. */
+    uint32_t timeout;
+
+    /*!< The action called when the state is entered, it can be NULL. */
+    pStateAction entry;
+
+    /*!< The action called when the state is left, it can be NULL. */
+    pStateAction exit;
+
+} WETS_State_t;
+
+/*!
+ * A transition.
+ */
+typedef struct _WETS_Transition
+{
+    /*!< The target state, \ref WETS_INTERNAL_STATE or \ref WETS_NO_STATE. */
+    uint8_t target;
+
+    /*!< The action called between the exit and the entry actions, it can
+         be NULL. */
+    pStateAction action;
+
+} WETS_Transition_t;
+
+/*!
+ * The description of a state machine, usually a constant.
+ */
+typedef struct _WETS_StateMachineTable
+{
+    /*!< The states. */
+    const WETS_State_t* states;
+
+    /*!< The number of states. */
+    uint8_t stateCount;
+
+    /*!< The transitions, stateCount rows of one transition for each input
+         event, in the order of the bits of the events mask from the least
+         significant one. */
+    const WETS_Transition_t* transitions;
+
+    /*!< The input events, bits of the priority group of the machine. */
+    uint32_t events;
+
+    /*!< The input event generated by the timeouts, 0 when there isn't any
+         timeout. */
+    uint32_t timeout;
+
+    /*!< The state entered when the machine starts. */
+    uint8_t initial;
+
+} WETS_StateMachineTable_t;
+
+/*!
+ * A running state machine.
+ */
+struct _WETS_StateMachine
+{
+    /*!< The description of the machine. */
+    const WETS_StateMachineTable_t* table;
+
+    /*!< The priority group of the input events. */
+    uint8_t priority;
+
+    /*!< The current state, always a leaf. */
+    uint8_t state;
+
+    /*!< The user data. */
+    void* context;
+};
+
+/*!
+ * This function starts a state machine: the initial state is entered, and
+ * the input events of the machine are bound to it.
+ *
+ * \param[out] machine: The machine, that must live until it is stopped.
+ * \param[in]    table: The description of the machine.
+ * \param[in] priority: The priority group of the input events.
+ * \param[in]  context: The user data.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the machine was started.
+ *         \arg \ref WETS_ERROR_NO_FSM_AVAILABLE when there isn't available
+ *                   spaces for the new machine.
+ *         \arg \ref WETS_ERROR_FSM_EVENT_USED when an input event is used
+ *                   by another machine.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid, or when a parent or an initial child of
+ *                   the states is not valid, or a state is nested deeper
+ *                   than \ref WETS_MAX_STATE_DEPTH.
+ */
+WETS_Error_t WETS_startStateMachine (WETS_StateMachine_t* machine,
+                                     const WETS_StateMachineTable_t* table,
+                                     uint8_t priority,
+                                     void* context);
+
+/*!
+ * This function stops a state machine. The exit actions are not called.
+ *
+ * \param[in] machine: The machine.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the machine was stopped.
+ *         \arg \ref WETS_ERROR_NO_FSM_FOUND when the machine is not running.
+ */
+WETS_Error_t WETS_stopStateMachine (WETS_StateMachine_t* machine);
+
+/*!
+ * This function clear all state machines.
+ */
+void WETS_removeAllStateMachines (void);
+
+/*!
+ * This function adds an input event of a state machine.
+ *
+ * \param[in] machine: The machine.
+ * \param[in]   event: The input event.
+ * \return The same values of \ref WETS_addEvent.
+ */
+WETS_Error_t WETS_postStateEvent (WETS_StateMachine_t* machine, uint32_t event);
+
+/*!
+ * This function adds an input event of a state machine after a delay.
+ *
+ * \param[in] machine: The machine.
+ * \param[in]   event: The input event.
+ * \param[in] timeout: The delay in milli-second.
+ * \return The same values of \ref WETS_addDelayEvent.
+ */
+WETS_Error_t WETS_postDelayStateEvent (WETS_StateMachine_t* machine,
+                                       uint32_t event,
+                                       uint32_t timeout);
+
+/*!
+ * This function checks whether a state is active: the current state or
+ * one of its parents.
+ *
+ * \param[in] machine: The machine.
+ * \param[in]   state: The state.
+ * \return TRUE when the state is active, FALSE otherwise.
+ */
+bool WETS_isInState (const WETS_StateMachine_t* machine, uint8_t state);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_FSM_H
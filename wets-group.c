@@ -0,0 +1,474 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-group.c
+ * \brief
+ */
+
+#include "wets-group.h"
+#include "wets-event.h"
+#include "wets-delay.h"
+#if (WETS_USE_RECORDER == 1)
+#include "wets-record.h"
+#endif
+
+#if (WETS_USE_EVENT_GROUP == 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_EventGroup
+ * \{
+ */
+
+/*!
+ * A group class.
+ */
+typedef struct _WETS_Group
+{
+    /*!< The priority of the group event, \ref WETS_NO_PRIORITY for a free
+         group. */
+    uint8_t priority;
+
+    /*!< The group event. */
+    uint32_t event;
+
+    /*!< The callback of the group event. */
+    pEventCallback cb;
+
+    /*!< The priority of the waited events. */
+    uint8_t sourcePriority;
+
+    /*!< The mask of the waited events. */
+    uint32_t mask;
+
+    /*!< The waited events already occurred. */
+    uint32_t occurred;
+
+    /*!< The condition. */
+    WETS_GroupMode_t mode;
+
+    /*!< Whether a delayed event is the timeout of the group. */
+    bool timeout;
+
+} WETS_Group_t;
+
+/*!
+ * The list of groups.
+ */
+static WETS_Group_t mGroups[WETS_MAX_EVENT_GROUPS];
+
+/*!
+ * The union of the waited events and of the group events of each priority,
+ * used to skip the table for the events that nobody waits.
+ */
+static uint32_t mWatched[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The function computes again the watched masks of each priority.
+ *
+ * \note It must be called in critical section, with the table that it
+ *       reads.
+ */
+static void updateWatched (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mWatched[i] = 0ul;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_GROUPS; ++i)
+    {
+        if (mGroups[i].priority != WETS_NO_PRIORITY)
+        {
+            mWatched[mGroups[i].sourcePriority] |= mGroups[i].mask;
+            mWatched[mGroups[i].priority]       |= mGroups[i].event;
+        }
+    }
+}
+
+/*!
+ * The function searches a group by its event.
+ *
+ * \param[in] priority: The priority of the group event,
+ *                      \ref WETS_NO_PRIORITY for a free group.
+ * \param[in]    event: The group event.
+ * \return The index of the group if it is found,
+ *         \ref WETS_MAX_EVENT_GROUPS otherwise.
+ */
+static uint8_t findGroup (uint8_t priority, uint32_t event)
+{
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_GROUPS; ++i)
+    {
+        if ((mGroups[i].priority == priority) &&
+            ((priority == WETS_NO_PRIORITY) || (mGroups[i].event == event)))
+        {
+            return i;
+        }
+    }
+    return WETS_MAX_EVENT_GROUPS;
+}
+
+/*!
+ * The function checks the condition of a group.
+ */
+static inline bool isGroupDone (const WETS_Group_t* group)
+{
+    if (group->mode == WETS_GROUP_ALL)
+    {
+        return (group->occurred == group->mask);
+    }
+    return (group->occurred > 0ul);
+}
+
+/*!
+ * The function releases a group.
+ *
+ * \param[in] group: The index of the group.
+ */
+static inline void clearGroup (uint8_t group)
+{
+    mGroups[group].priority       = WETS_NO_PRIORITY;
+    mGroups[group].event          = WETS_NO_EVENT;
+    mGroups[group].cb             = NULL;
+    mGroups[group].sourcePriority = WETS_NO_PRIORITY;
+    mGroups[group].mask           = 0ul;
+    mGroups[group].occurred       = 0ul;
+    mGroups[group].timeout        = FALSE;
+}
+
+/*!
+ * The function releases a group and stops its timeout. The watched masks
+ * are left to the caller.
+ *
+ * \note It must be called in critical section.
+ *
+ * \param[in] group: The index of the group.
+ * \return TRUE when the group had a timeout, FALSE otherwise.
+ */
+static bool dropGroup (uint8_t group)
+{
+    bool timeout = mGroups[group].timeout;
+
+    if (timeout)
+    {
+        WETS_disarmDelayEvent(mGroups[group].priority,mGroups[group].event);
+    }
+    clearGroup(group);
+    return timeout;
+}
+
+/*!
+ * The function records the stop of the timeout of a group, out of the
+ * critical section that stopped it.
+ *
+ * \param[in] priority: The priority of the group event.
+ * \param[in]    event: The group event.
+ */
+static inline void recordTimeout (uint8_t priority, uint32_t event)
+{
+#if (WETS_USE_RECORDER == 1)
+    WETS_record(WETS_RECORD_REMOVE_DELAY,priority,event,0);
+#else
+    (void)priority;
+    (void)event;
+#endif
+}
+
+/*!
+ * The function removes a group whose condition holds, with its timeout, so
+ * that it fires once.
+ *
+ * \note It must be called in critical section, in the same one that
+ *       evaluated the condition.
+ *
+ * \param[in]  group: The index of the group.
+ * \param[out] taken: The removed group, to be given to \ref fireGroup.
+ */
+static void takeGroup (uint8_t group, WETS_Group_t* taken)
+{
+    *taken = mGroups[group];
+
+    dropGroup(group);
+    updateWatched();
+}
+
+/*!
+ * The function posts the event of a group taken by \ref takeGroup.
+ *
+ * \param[in] fired: The removed group.
+ */
+static void fireGroup (const WETS_Group_t* fired)
+{
+    if (fired->timeout)
+    {
+        recordTimeout(fired->priority,fired->event);
+    }
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    WETS_addPayloadEvent(fired->cb,fired->priority,fired->event,fired->occurred);
+#else
+    WETS_addEvent(fired->cb,fired->priority,fired->event);
+#endif
+}
+
+/*!
+ * The function fills a free group, the events of the mask already pending
+ * are counted as occurred. The priority is written last, to publish it.
+ *
+ * \note It must be called in critical section.
+ */
+static void fillGroup (uint8_t group,
+                       pEventCallback cb,
+                       uint8_t priority,
+                       uint32_t event,
+                       uint8_t sourcePriority,
+                       uint32_t mask,
+                       WETS_GroupMode_t mode,
+                       uint32_t timeout)
+{
+    mGroups[group].event          = event;
+    mGroups[group].cb             = cb;
+    mGroups[group].sourcePriority = sourcePriority;
+    mGroups[group].mask           = mask;
+    mGroups[group].mode           = mode;
+    mGroups[group].timeout        = (timeout > 0);
+    mGroups[group].occurred       = 0ul;
+    for (uint32_t bit = 1ul; (bit != 0ul) && (bit <= mask); bit <<= 1)
+    {
+        if (((mask & bit) > 0ul) && WETS_isEvent(sourcePriority,bit))
+        {
+            mGroups[group].occurred |= bit;
+        }
+    }
+    mGroups[group].priority       = priority;
+}
+
+WETS_Error_t WETS_addEventGroup (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint8_t sourcePriority,
+                                 uint32_t mask,
+                                 WETS_GroupMode_t mode,
+                                 uint32_t timeout)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(mask > 0ul);
+    err |= ohiassert(sourcePriority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(mode <= WETS_GROUP_ALL);
+    err |= ohiassert(cb != NULL);
+    // The group event can't wait for itself
+    err |= ohiassert((priority != sourcePriority) || ((mask & event) == 0ul));
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_SUCCESS;
+        WETS_Group_t fired;
+        bool done = FALSE;
+        bool replaced = FALSE;
+
+        if (timeout > 0)
+        {
+            // Clear current event, if present, like a delayed event
+            WETS_removeEvent(priority,event);
+        }
+
+        // The group is filled in critical section, and it is published by
+        // its priority, so that the posts of the waited events see it
+        // complete or don't see it at all
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        // A new group replaces the old one with the same event
+        uint8_t group = findGroup(priority,event);
+        if (group < WETS_MAX_EVENT_GROUPS)
+        {
+            replaced = dropGroup(group);
+        }
+
+        group = findGroup(WETS_NO_PRIORITY,WETS_NO_EVENT);
+        if (group == WETS_MAX_EVENT_GROUPS)
+        {
+            result = WETS_ERROR_NO_GROUP_AVAILABLE;
+        }
+        else if (timeout > 0)
+        {
+            result = WETS_armDelayEvent(cb,priority,event,timeout);
+        }
+
+        if (result == WETS_ERROR_SUCCESS)
+        {
+            fillGroup(group,cb,priority,event,sourcePriority,mask,mode,timeout);
+            done = isGroupDone(&mGroups[group]);
+            if (done)
+            {
+                takeGroup(group,&fired);
+            }
+            else
+            {
+                updateWatched();
+            }
+        }
+        else
+        {
+            updateWatched();
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        if (replaced)
+        {
+            recordTimeout(priority,event);
+        }
+#if (WETS_USE_RECORDER == 1)
+        if ((timeout > 0) && (result == WETS_ERROR_SUCCESS))
+        {
+            WETS_record(WETS_RECORD_DELAY,priority,event,timeout);
+        }
+#endif
+        if (done)
+        {
+            fireGroup(&fired);
+        }
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_removeEventGroup (uint8_t priority, uint32_t event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        WETS_Error_t result = WETS_ERROR_SUCCESS;
+        bool timeout = FALSE;
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        uint8_t group = findGroup(priority,event);
+        if (group == WETS_MAX_EVENT_GROUPS)
+        {
+            result = WETS_ERROR_NO_GROUP_FOUND;
+        }
+        else
+        {
+            timeout = dropGroup(group);
+            updateWatched();
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        if (timeout)
+        {
+            recordTimeout(priority,event);
+        }
+        return result;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+void WETS_removeAllEventGroups (void)
+{
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_GROUPS; ++i)
+    {
+        clearGroup(i);
+    }
+    updateWatched();
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+}
+
+void WETS_resolveEventGroups (uint8_t priority, uint32_t event)
+{
+    // Most of the events are not waited
+    if ((mWatched[priority] & event) == 0ul)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_EVENT_GROUPS; ++i)
+    {
+        WETS_Group_t* group = &mGroups[i];
+        WETS_Group_t fired;
+        bool done = FALSE;
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_BEGIN();
+#endif
+        if ((group->priority == priority) && (group->event == event))
+        {
+            // The group event was posted by the timeout or by the user
+            clearGroup(i);
+            updateWatched();
+        }
+        else if ((group->priority != WETS_NO_PRIORITY) &&
+                 (group->sourcePriority == priority) && ((group->mask & event) > 0ul))
+        {
+            group->occurred |= (group->mask & event);
+            if (isGroupDone(group))
+            {
+                // Take the group, so that it fires once
+                takeGroup(i,&fired);
+                done = TRUE;
+            }
+        }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+        CRITICAL_SECTION_END();
+#endif
+
+        if (done)
+        {
+            fireGroup(&fired);
+        }
+    }
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_EVENT_GROUP
@@ -0,0 +1,153 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-group.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_GROUP_H
+#define __WARCOMEB_WETS_GROUP_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_EventGroup WETS Event Groups Management
+ * \ingroup  WETS
+ * \{
+ *
+ * An event group waits for a set of events of a priority: when any of them
+ * (or all of them) has been posted, the group posts its own event once and
+ * it is removed. The condition is evaluated with bit masks each time an
+ * event is posted, so the waiting callback is neither polled nor
+ * dispatched before the condition holds.
+ *
+ * When \ref WETS_USE_EVENT_PAYLOAD is enabled, the payload of the group
+ * event is the mask of the events occurred, 0 when the group expired.
+ *
+ * The table is changed in critical section, so the waited events can be
+ * posted from an interrupt: the condition is evaluated, the group removed
+ * and its timeout cancelled in the context of the post, and the group event
+ * is posted after the critical section.
+ *
+ * \note \ref WETS_addEventGroup and \ref WETS_removeEventGroup scan the
+ *       table and the timers with the interrupts disabled, so they should
+ *       be called from the main loop or from a callback, not from an
+ *       interrupt. They require \ref WETS_USE_CRITICAL_SECTION when the
+ *       events are posted by interrupts or by other threads.
+ */
+
+#if !defined (WETS_MAX_EVENT_GROUPS)
+#define WETS_MAX_EVENT_GROUPS                    8u
+#endif
+
+/*!
+ * The condition of a group.
+ */
+typedef enum _WETS_GroupMode
+{
+    /*!< The group fires at the first event of the mask. */
+    WETS_GROUP_ANY = 0,
+    /*!< The group fires when all the events of the mask have occurred. */
+    WETS_GROUP_ALL,
+
+} WETS_GroupMode_t;
+
+/*!
+ * This function is called to add a group. The events of the mask already
+ * pending are counted as occurred.
+ * When a timeout is given, a delayed event posts the group event when the
+ * timeout expires before the condition, and the group is removed. The
+ * group is removed also when its event is posted by the application, but
+ * the timeout must be cancelled with \ref WETS_removeEventGroup.
+ *
+ * \param[in]             cb: The callback for the group event.
+ * \param[in]       priority: The priority group for the group event.
+ * \param[in]          event: The group event to be notified.
+ * \param[in] sourcePriority: The priority group of the waited events.
+ * \param[in]           mask: The mask of the waited events.
+ * \param[in]           mode: The condition, \ref WETS_GroupMode_t.
+ * \param[in]        timeout: The timeout in milli-second, 0 to wait forever.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the group was created.
+ *         \arg \ref WETS_ERROR_NO_GROUP_AVAILABLE when there isn't available
+ *                   spaces for the new group.
+ *         \arg \ref WETS_ERROR_NO_TIMER_AVAILABLE when there isn't available
+ *                   timers for the timeout.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_addEventGroup (pEventCallback cb,
+                                 uint8_t priority,
+                                 uint32_t event,
+                                 uint8_t sourcePriority,
+                                 uint32_t mask,
+                                 WETS_GroupMode_t mode,
+                                 uint32_t timeout);
+
+/*!
+ * This function is called to remove a group and its timeout.
+ *
+ * \param[in] priority: The priority group for the group event.
+ * \param[in]    event: The group event.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the group was removed.
+ *         \arg \ref WETS_ERROR_NO_GROUP_FOUND when the group was not found.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_removeEventGroup (uint8_t priority, uint32_t event);
+
+/*!
+ * This function clear all groups.
+ */
+void WETS_removeAllEventGroups (void);
+
+/*!
+ * This function it is called by the scheduler each time a new event is
+ * posted.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] priority: The priority group of the posted event.
+ * \param[in]    event: The posted event.
+ */
+void WETS_resolveEventGroups (uint8_t priority, uint32_t event);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_GROUP_H
@@ -0,0 +1,361 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-id.c
+ * \brief
+ */
+
+#include "wets-id.h"
+#include "wets-event.h"
+#include "wets-delay.h"
+#include "wets-cyclic.h"
+
+#if (WETS_USE_EVENT_ID == 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_EventId
+ * \{
+ */
+
+#define WETS_EVENT_ID_TABLE_SIZE                 (1u << WETS_EVENT_ID_TABLE_BITS)
+
+/*!
+ * An entry of the hash table.
+ */
+typedef struct _WETS_EventId
+{
+    /*!< The identifier. */
+    uint32_t id;
+
+    /*!< The priority group, \ref WETS_NO_PRIORITY for a free entry. */
+    uint8_t priority;
+
+    /*!< The rank, that is the bit of the event. */
+    uint8_t rank;
+
+} WETS_EventId_t;
+
+/*!
+ * The hash table of the identifiers.
+ */
+static WETS_EventId_t mTable[WETS_EVENT_ID_TABLE_SIZE];
+
+/*!
+ * The identifier of each bit of each priority group.
+ */
+static uint32_t mIds[WETS_MAX_PRIORITY_LEVEL][32];
+
+/*!
+ * The bits used into each priority group.
+ */
+static uint32_t mUsed[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The function returns the first entry to be checked for an identifier,
+ * with a multiplicative hash.
+ */
+static inline uint32_t getHash (uint32_t id)
+{
+    return (uint32_t)(id * 0x9E3779B1ul) >> (32u - WETS_EVENT_ID_TABLE_BITS);
+}
+
+/*!
+ * The function searches an identifier, with linear probing.
+ *
+ * \param[in] id: The identifier.
+ * \return The entry of the identifier, NULL when it is not registered.
+ */
+static WETS_EventId_t* findId (uint32_t id)
+{
+    uint32_t index = getHash(id);
+
+    for (uint32_t i = 0; i < WETS_EVENT_ID_TABLE_SIZE; ++i)
+    {
+        WETS_EventId_t* entry = &mTable[index];
+
+        if (entry->priority == WETS_NO_PRIORITY)
+        {
+            break;
+        }
+        if (entry->id == id)
+        {
+            return entry;
+        }
+        index = (index + 1u) & (WETS_EVENT_ID_TABLE_SIZE - 1u);
+    }
+    return NULL;
+}
+
+/*!
+ * The function returns the index of the most important bit of an event.
+ */
+static inline uint8_t getRank (uint32_t event)
+{
+    uint8_t rank = 31u;
+    while ((event & (1ul << rank)) == 0ul)
+    {
+        rank--;
+    }
+    return rank;
+}
+
+WETS_Error_t WETS_registerEventId (uint32_t id, uint8_t priority, uint8_t rank)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(id != WETS_NO_EVENT);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert((rank < 32u) || (rank == WETS_ANY_RANK));
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        if (findId(id) != NULL)
+        {
+            return WETS_ERROR_ID_USED;
+        }
+
+        if (rank == WETS_ANY_RANK)
+        {
+            if (mUsed[priority] == 0xFFFFFFFFul)
+            {
+                return WETS_ERROR_NO_ID_AVAILABLE;
+            }
+            rank = 0;
+            while ((mUsed[priority] & (1ul << rank)) > 0ul)
+            {
+                rank++;
+            }
+        }
+        else if ((mUsed[priority] & (1ul << rank)) > 0ul)
+        {
+            return WETS_ERROR_ID_USED;
+        }
+
+        // The first free entry of the sequence
+        uint32_t index = getHash(id);
+        for (uint32_t i = 0; i < WETS_EVENT_ID_TABLE_SIZE; ++i)
+        {
+            WETS_EventId_t* entry = &mTable[index];
+
+            if (entry->priority == WETS_NO_PRIORITY)
+            {
+                entry->id       = id;
+                entry->rank     = rank;
+                entry->priority = priority;
+
+                mIds[priority][rank] = id;
+                mUsed[priority] |= (1ul << rank);
+                return WETS_ERROR_SUCCESS;
+            }
+            index = (index + 1u) & (WETS_EVENT_ID_TABLE_SIZE - 1u);
+        }
+        return WETS_ERROR_NO_ID_AVAILABLE;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_unregisterEventId (uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+
+    mUsed[entry->priority] &= ~(1ul << entry->rank);
+    mIds[entry->priority][entry->rank] = WETS_NO_EVENT;
+
+    // The entries of the sequence after the removed one are moved back
+    // into the hole when their first entry is not between the hole and
+    // them, so that the searches never stop early and no removed entry
+    // is left to slow them down
+    uint32_t hole = (uint32_t)(entry - mTable);
+    uint32_t index = hole;
+    for (uint32_t i = 1; i < WETS_EVENT_ID_TABLE_SIZE; ++i)
+    {
+        index = (index + 1u) & (WETS_EVENT_ID_TABLE_SIZE - 1u);
+        if (mTable[index].priority == WETS_NO_PRIORITY)
+        {
+            break;
+        }
+
+        uint32_t home = getHash(mTable[index].id);
+        uint32_t fromHome = (index - home) & (WETS_EVENT_ID_TABLE_SIZE - 1u);
+        uint32_t fromHole = (index - hole) & (WETS_EVENT_ID_TABLE_SIZE - 1u);
+        if (fromHome >= fromHole)
+        {
+            mTable[hole] = mTable[index];
+            hole = index;
+        }
+    }
+
+    mTable[hole].id       = WETS_NO_EVENT;
+    mTable[hole].priority = WETS_NO_PRIORITY;
+    mTable[hole].rank     = 0;
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_removeAllEventIds (void)
+{
+    for (uint32_t i = 0; i < WETS_EVENT_ID_TABLE_SIZE; ++i)
+    {
+        mTable[i].id       = WETS_NO_EVENT;
+        mTable[i].priority = WETS_NO_PRIORITY;
+        mTable[i].rank     = 0;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mUsed[i] = 0ul;
+        for (uint8_t j = 0; j < 32u; ++j)
+        {
+            mIds[i][j] = WETS_NO_EVENT;
+        }
+    }
+}
+
+WETS_Error_t WETS_findEventId (uint32_t id, uint8_t* priority, uint32_t* event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(priority != NULL);
+    err |= ohiassert(event != NULL);
+
+    if (err != ERRORS_NO_ERROR)
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+
+    *priority = entry->priority;
+    *event    = (1ul << entry->rank);
+    return WETS_ERROR_SUCCESS;
+}
+
+uint32_t WETS_getEventId (uint8_t priority, uint32_t event)
+{
+    if ((priority >= WETS_MAX_PRIORITY_LEVEL) || (event == 0ul))
+    {
+        return WETS_NO_EVENT;
+    }
+    return mIds[priority][getRank(event)];
+}
+
+WETS_Error_t WETS_addIdEvent (pEventCallback cb, uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_addEvent(cb,entry->priority,(1ul << entry->rank));
+}
+
+WETS_Error_t WETS_removeIdEvent (uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_removeEvent(entry->priority,(1ul << entry->rank));
+}
+
+bool WETS_isIdEvent (uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    return (entry != NULL) && WETS_isEvent(entry->priority,(1ul << entry->rank));
+}
+
+WETS_Error_t WETS_addDelayIdEvent (pEventCallback cb, uint32_t id, uint32_t timeout)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_addDelayEvent(cb,entry->priority,(1ul << entry->rank),timeout);
+}
+
+WETS_Error_t WETS_removeDelayIdEvent (uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_removeDelayEvent(entry->priority,(1ul << entry->rank));
+}
+
+WETS_Error_t WETS_addCyclicIdEvent (pEventCallback cb, uint32_t id, uint32_t cycle)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_addCyclicEvent(cb,entry->priority,(1ul << entry->rank),cycle);
+}
+
+WETS_Error_t WETS_removeCyclicIdEvent (uint32_t id)
+{
+    WETS_EventId_t* entry = findId(id);
+
+    if (entry == NULL)
+    {
+        return WETS_ERROR_NO_ID_FOUND;
+    }
+    return WETS_removeCyclicEvent(entry->priority,(1ul << entry->rank));
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_EVENT_ID
@@ -0,0 +1,170 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-id.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_ID_H
+#define __WARCOMEB_WETS_ID_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_EventId WETS Event Identifiers Management
+ * \ingroup  WETS
+ * \{
+ *
+ * An event identifier is an arbitrary 32-bit value, that is registered once
+ * with its priority group and its rank: the scheduler assigns to it the bit
+ * of the rank into the status word of the group, so that the modules don't
+ * have to share the allocation of the bits. The higher is the rank, the more
+ * important is the event.
+ * The identifiers are stored into a fixed-size open-addressing hash table:
+ * the translation of an identifier into its group and bit takes a constant
+ * time on average, bounded by the size of the table. A removed identifier
+ * leaves no mark into the table, so the lookups don't slow down with the
+ * removals. Only the translation is hashed: the wrappers of the event
+ * functions then call them, and keep their cost, like the scan of the slots
+ * of the group or of the timers.
+ */
+
+/*!
+ * The hash table has 2^WETS_EVENT_ID_TABLE_BITS entries, it should be about
+ * twice the number of registered identifiers.
+ */
+#if !defined (WETS_EVENT_ID_TABLE_BITS)
+#define WETS_EVENT_ID_TABLE_BITS                 6u
+#endif
+
+/*!
+ * The rank to be chosen by the scheduler: the least important free bit.
+ */
+#define WETS_ANY_RANK                            0xFFu
+
+/*!
+ * This function registers an event identifier.
+ *
+ * \param[in]       id: The identifier, any value except \ref WETS_NO_EVENT.
+ * \param[in] priority: The priority group of the event.
+ * \param[in]     rank: The importance of the event into its group, from 0
+ *                      to 31, or \ref WETS_ANY_RANK.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the identifier was registered.
+ *         \arg \ref WETS_ERROR_ID_USED when the identifier, or the
+ *                   rank into the group, is already used.
+ *         \arg \ref WETS_ERROR_NO_ID_AVAILABLE when the table or the
+ *                   group are full.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_registerEventId (uint32_t id, uint8_t priority, uint8_t rank);
+
+/*!
+ * This function removes an event identifier. The pending event and the
+ * timers of the identifier are not removed.
+ *
+ * \param[in] id: The identifier.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the identifier was removed.
+ *         \arg \ref WETS_ERROR_NO_ID_FOUND when the identifier is not
+ *                   registered.
+ */
+WETS_Error_t WETS_unregisterEventId (uint32_t id);
+
+/*!
+ * This function removes all the event identifiers.
+ */
+void WETS_removeAllEventIds (void);
+
+/*!
+ * This function returns the priority group and the event bit of an
+ * identifier.
+ *
+ * \param[in]        id: The identifier.
+ * \param[out] priority: The priority group of the event.
+ * \param[out]    event: The event bit.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the identifier was found.
+ *         \arg \ref WETS_ERROR_NO_ID_FOUND when the identifier is not
+ *                   registered.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_findEventId (uint32_t id, uint8_t* priority, uint32_t* event);
+
+/*!
+ * This function returns the identifier of the most important event of a
+ * status word, so that a callback can find the identifier of the event
+ * that it is serving.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]    event: The event bits.
+ * \return The identifier, \ref WETS_NO_EVENT when the event is not
+ *         registered.
+ */
+uint32_t WETS_getEventId (uint8_t priority, uint32_t event);
+
+/*!
+ * These functions are the same of \ref WETS_addEvent, \ref WETS_removeEvent,
+ * \ref WETS_isEvent and of the delayed and cyclic events functions, with an
+ * identifier instead of the priority group and of the event bit.
+ * They return \ref WETS_ERROR_NO_ID_FOUND when the identifier is not
+ * registered.
+ */
+WETS_Error_t WETS_addIdEvent (pEventCallback cb, uint32_t id);
+
+WETS_Error_t WETS_removeIdEvent (uint32_t id);
+
+bool WETS_isIdEvent (uint32_t id);
+
+WETS_Error_t WETS_addDelayIdEvent (pEventCallback cb,
+                                   uint32_t id,
+                                   uint32_t timeout);
+
+WETS_Error_t WETS_removeDelayIdEvent (uint32_t id);
+
+WETS_Error_t WETS_addCyclicIdEvent (pEventCallback cb,
+                                    uint32_t id,
+                                    uint32_t cycle);
+
+WETS_Error_t WETS_removeCyclicIdEvent (uint32_t id);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_ID_H
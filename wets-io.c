@@ -0,0 +1,334 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-io.c
+ * \brief
+ */
+
+#include "wets-io.h"
+#include "wets-event.h"
+
+#if (WETS_USE_IO_SOURCES == 1)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_IoSource
+ * \{
+ */
+
+/*!
+ * The epoll data of the descriptor used to wake-up the wait.
+ */
+#define WETS_IO_DOORBELL                         0xFFFFFFFFul
+
+/*!
+ * An I/O source class.
+ */
+typedef struct _WETS_IoSource
+{
+    /*!< The file descriptor, -1 when the source is free. */
+    int fd;
+
+    /*!< The event priority. */
+    uint8_t priority;
+
+    /*!< The event flag generated when the descriptor is ready. */
+    uint32_t event;
+
+    /*!< The callback that will be called when the event is fired. */
+    pEventCallback cb;
+
+} WETS_IoSource_t;
+
+/*!
+ * The list of sources.
+ */
+static WETS_IoSource_t mSources[WETS_MAX_IO_SOURCES];
+
+/*!
+ * The epoll instance, -1 until the first use.
+ */
+static int mEpoll = -1;
+
+/*!
+ * The eventfd used to wake-up the wait from other threads.
+ */
+static int mDoorbell = -1;
+
+#if (WETS_IO_DRIVES_TICK == 1)
+/*!
+ * The monotonic time, in milli-second, of the last tick.
+ */
+static uint64_t mLastTick = 0;
+#endif
+
+/*!
+ * The function returns the monotonic time in milli-second.
+ */
+static uint64_t getMonotonicTime (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000u) + ((uint64_t)ts.tv_nsec / 1000000u);
+}
+
+/*!
+ * The function creates the epoll instance and its doorbell at the first use.
+ *
+ * \return TRUE when epoll is ready, FALSE otherwise.
+ */
+static bool openEpoll (void)
+{
+    if (mEpoll >= 0)
+    {
+        return TRUE;
+    }
+
+    mEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpoll < 0)
+    {
+        return FALSE;
+    }
+
+    mDoorbell = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mDoorbell >= 0)
+    {
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = WETS_IO_DOORBELL };
+        epoll_ctl(mEpoll,EPOLL_CTL_ADD,mDoorbell,&ev);
+    }
+
+#if (WETS_IO_DRIVES_TICK == 1)
+    mLastTick = getMonotonicTime();
+#endif
+    return TRUE;
+}
+
+/*!
+ * The function searches the source of a descriptor.
+ *
+ * \param[in] fd: The descriptor to be searched, -1 for a free source.
+ * \return The index of the source if it is found,
+ *         \ref WETS_MAX_IO_SOURCES otherwise.
+ */
+static uint8_t findSource (int fd)
+{
+    for (uint8_t i = 0; i < WETS_MAX_IO_SOURCES; ++i)
+    {
+        if (mSources[i].fd == fd)
+        {
+            return i;
+        }
+    }
+    return WETS_MAX_IO_SOURCES;
+}
+
+WETS_Error_t WETS_addIoSource (int fd,
+                               uint8_t mask,
+                               pEventCallback cb,
+                               uint8_t priority,
+                               uint32_t event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(fd >= 0);
+    err |= ohiassert((mask & (WETS_IO_READ | WETS_IO_WRITE)) > 0);
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(cb != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        if ((findSource(fd) < WETS_MAX_IO_SOURCES) || !openEpoll())
+        {
+            return WETS_ERROR_IO_FAILED;
+        }
+
+        uint8_t source = findSource(-1);
+        if (source == WETS_MAX_IO_SOURCES)
+        {
+            return WETS_ERROR_NO_IO_AVAILABLE;
+        }
+
+        struct epoll_event ev = { .events = 0, .data.u32 = source };
+        if ((mask & WETS_IO_READ) > 0)  ev.events |= EPOLLIN;
+        if ((mask & WETS_IO_WRITE) > 0) ev.events |= EPOLLOUT;
+
+        if (epoll_ctl(mEpoll,EPOLL_CTL_ADD,fd,&ev) != 0)
+        {
+            return WETS_ERROR_IO_FAILED;
+        }
+
+        mSources[source].cb       = cb;
+        mSources[source].priority = priority;
+        mSources[source].event    = event;
+        mSources[source].fd       = fd;
+
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_removeIoSource (int fd)
+{
+    uint8_t source = findSource(fd);
+
+    if ((fd < 0) || (source == WETS_MAX_IO_SOURCES))
+    {
+        return WETS_ERROR_NO_IO_FOUND;
+    }
+
+    epoll_ctl(mEpoll,EPOLL_CTL_DEL,fd,NULL);
+
+    mSources[source].fd       = -1;
+    mSources[source].cb       = NULL;
+    mSources[source].priority = WETS_NO_PRIORITY;
+    mSources[source].event    = WETS_NO_EVENT;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_removeAllIoSources (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_IO_SOURCES; ++i)
+    {
+        if ((mSources[i].fd >= 0) && (mEpoll >= 0))
+        {
+            epoll_ctl(mEpoll,EPOLL_CTL_DEL,mSources[i].fd,NULL);
+        }
+        mSources[i].fd       = -1;
+        mSources[i].cb       = NULL;
+        mSources[i].priority = WETS_NO_PRIORITY;
+        mSources[i].event    = WETS_NO_EVENT;
+    }
+}
+
+uint8_t WETS_waitIoSources (uint32_t timeout)
+{
+    struct epoll_event ready[WETS_MAX_IO_SOURCES + 1];
+    uint8_t generated = 0;
+
+    if (!openEpoll())
+    {
+        return 0;
+    }
+
+    int wait = -1;
+    if (timeout != WETS_NO_TIMEOUT)
+    {
+#if (WETS_IO_DRIVES_TICK == 1)
+        // Part of the current tick is already elapsed
+        uint64_t elapsed = getMonotonicTime() - mLastTick;
+        wait = (elapsed >= timeout) ? 0 : (int)(timeout - elapsed);
+#else
+        wait = (int)timeout;
+#endif
+    }
+
+    int count = epoll_wait(mEpoll,ready,WETS_MAX_IO_SOURCES + 1,wait);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (ready[i].data.u32 == WETS_IO_DOORBELL)
+        {
+            uint64_t value;
+            // Just clear the doorbell, the posted events are drained by the loop
+            (void)read(mDoorbell,&value,sizeof(value));
+            continue;
+        }
+
+        WETS_IoSource_t* source = &mSources[ready[i].data.u32];
+        if (source->fd < 0)
+        {
+            continue;
+        }
+
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+        uintptr_t readiness = 0;
+        if ((ready[i].events & EPOLLIN) > 0)                 readiness |= WETS_IO_READ;
+        if ((ready[i].events & EPOLLOUT) > 0)                readiness |= WETS_IO_WRITE;
+        if ((ready[i].events & (EPOLLERR | EPOLLHUP)) > 0)   readiness |= WETS_IO_ERROR;
+        WETS_Error_t err = WETS_addPayloadEvent(source->cb,source->priority,source->event,readiness);
+#else
+        WETS_Error_t err = WETS_addEvent(source->cb,source->priority,source->event);
+#endif
+        // The sources are level-triggered: a refused descriptor is still
+        // ready, and it is reported again by the next wait
+        if (err == WETS_ERROR_EVENT_RETRY)
+        {
+            continue;
+        }
+        generated++;
+    }
+
+#if (WETS_IO_DRIVES_TICK == 1)
+    // Generate the ticks elapsed during the wait
+    uint64_t now = getMonotonicTime();
+    while ((now - mLastTick) >= WETS_ISR_PERIOD_ms)
+    {
+        WETS_timerIsrCallback(NULL);
+        mLastTick += WETS_ISR_PERIOD_ms;
+    }
+#endif
+
+    return generated;
+}
+
+int WETS_getIoDoorbell (void)
+{
+    return openEpoll() ? mDoorbell : -1;
+}
+
+#if (WETS_USE_POST_QUEUE == 1)
+void WETS_doAfterPost (void)
+{
+    uint64_t value = 1;
+
+    if (mDoorbell >= 0)
+    {
+        (void)write(mDoorbell,&value,sizeof(value));
+    }
+}
+#endif
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_IO_SOURCES
@@ -0,0 +1,145 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-io.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_IO_H
+#define __WARCOMEB_WETS_IO_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_IoSource WETS I/O Sources Management
+ * \ingroup  WETS
+ * \{
+ *
+ * An I/O source binds a file descriptor (socket, serial port, pipe...) to an
+ * event: when the descriptor is ready, the event is generated and the
+ * callback invoked. The sources, the timers and the posted events share the
+ * single wait of the idle path: it sleeps into epoll_wait() with a timeout
+ * equal to the next timer deadline, and advances the scheduler time when it
+ * wakes-up, so no tick thread is needed.
+ */
+
+#if !defined (WETS_MAX_IO_SOURCES)
+#define WETS_MAX_IO_SOURCES                      8u
+#endif
+
+/*!
+ * Whether the wait advances the scheduler time with
+ * \ref WETS_timerIsrCallback. Set to 0 when another source calls it.
+ */
+#if !defined (WETS_IO_DRIVES_TICK)
+#define WETS_IO_DRIVES_TICK                      1u
+#endif
+
+/*!
+ * The readiness of a descriptor. When \ref WETS_USE_EVENT_PAYLOAD is enabled,
+ * the readiness that generated the event is its payload.
+ */
+#define WETS_IO_READ                             0x01u
+#define WETS_IO_WRITE                            0x02u
+#define WETS_IO_ERROR                            0x04u
+
+/*!
+ * This function is called to add a file descriptor as event source.
+ *
+ * \param[in]       fd: The file descriptor.
+ * \param[in]     mask: The readiness to wait, \ref WETS_IO_READ and/or
+ *                      \ref WETS_IO_WRITE.
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the source was added.
+ *         \arg \ref WETS_ERROR_NO_IO_AVAILABLE when there isn't available
+ *                   spaces for the new source.
+ *         \arg \ref WETS_ERROR_IO_FAILED when epoll refused the descriptor.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_addIoSource (int fd,
+                               uint8_t mask,
+                               pEventCallback cb,
+                               uint8_t priority,
+                               uint32_t event);
+
+/*!
+ * This function is called to remove a file descriptor from the sources.
+ *
+ * \param[in] fd: The file descriptor.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the source was removed.
+ *         \arg \ref WETS_ERROR_NO_IO_FOUND when the descriptor is not a
+ *                   source.
+ */
+WETS_Error_t WETS_removeIoSource (int fd);
+
+/*!
+ * This function clear all sources.
+ */
+void WETS_removeAllIoSources (void);
+
+/*!
+ * This function it is called inside the idle path of the scheduler
+ * (\ref WETS_loop()): it waits for a ready descriptor, a posted event or the
+ * next timer deadline, and generates the events of the ready descriptors.
+ * A descriptor whose event is refused with \ref WETS_ERROR_EVENT_RETRY is
+ * still ready, so it is reported again by the next wait.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] timeout: The longest wait in milli-second, or
+ *                     \ref WETS_NO_TIMEOUT to wait without limit.
+ * \return The number of events generated by the descriptors.
+ */
+uint8_t WETS_waitIoSources (uint32_t timeout);
+
+/*!
+ * This function returns the eventfd that wakes-up the wait of the idle path.
+ * Writing into it from another thread or process interrupts the wait.
+ *
+ * \return The file descriptor, or -1 when epoll can't be opened.
+ */
+int WETS_getIoDoorbell (void);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_IO_H
@@ -0,0 +1,691 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-ipc.c
+ * \brief
+ */
+
+// SO_PEERCRED and struct ucred
+#if !defined (_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "wets-ipc.h"
+#include "wets-event.h"
+#include "wets-io.h"
+
+#if (WETS_USE_IPC == 1)
+
+#if (WETS_USE_IO_SOURCES != 1)
+#error "WETS_USE_IPC requires WETS_USE_IO_SOURCES"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_IpcBus
+ * \{
+ */
+
+#if ((WETS_IPC_QUEUE_SIZE & (WETS_IPC_QUEUE_SIZE - 1u)) != 0u)
+#error "WETS_IPC_QUEUE_SIZE must be a power of two"
+#endif
+
+#define WETS_IPC_QUEUE_MASK                      (WETS_IPC_QUEUE_SIZE - 1u)
+
+#define WETS_IPC_MAGIC                           0x43504957ul // "WIPC"
+#define WETS_IPC_VERSION                         2u
+
+/*!
+ * A cell of the shared queue. The payload is aligned and the tail padded
+ * explicitly, so 32 and 64 bit processes use the same layout and stride.
+ */
+typedef struct _WETS_IpcCell
+{
+    /*!< The sequence number that gives the cell ownership. */
+    atomic_uint             sequence;
+
+    /*!< The event flag. */
+    uint32_t                event;
+
+    /*!< The user value attached to the event. */
+    _Alignas(8) uint64_t    payload;
+
+    /*!< The event priority. */
+    uint8_t                 priority;
+
+    uint8_t                 reserved[7];
+
+} WETS_IpcCell_t;
+
+_Static_assert(sizeof(WETS_IpcCell_t) == 24, "WETS: the IPC cell must have the same size in 32 and 64 bit");
+
+/*!
+ * The shared memory of a bus.
+ */
+typedef struct _WETS_IpcRing
+{
+    /*!< The bus identifier, written when the bus is ready. */
+    atomic_uint    magic;
+
+    uint16_t       version;
+
+    uint16_t       size;
+
+    /*!< The receiver process. */
+    int32_t        pid;
+
+    /*!< Whether the receiver is still attached. */
+    atomic_uint    open;
+
+    /*!< Whether the receiver waits for the doorbell. */
+    atomic_uint    sleeping;
+
+    /*!< The next position reserved by a producer, alone into its line. */
+    _Alignas(64) atomic_uint enqueue;
+
+    _Alignas(64) WETS_IpcCell_t cells[WETS_IPC_QUEUE_SIZE];
+
+} WETS_IpcRing_t;
+
+_Static_assert(offsetof(WETS_IpcRing_t,cells) == 128, "WETS: the IPC ring must have the same layout in 32 and 64 bit");
+
+/*!
+ * The binding of a received event to a local callback.
+ */
+typedef struct _WETS_IpcEvent
+{
+    uint8_t        priority;
+
+    uint32_t       event;
+
+    pEventCallback cb;
+
+} WETS_IpcEvent_t;
+
+/*!
+ * The bus of this process, NULL when it is not open.
+ */
+static WETS_IpcRing_t* mRing = NULL;
+
+static char mName[64];
+
+/*!
+ * The next position read by the scheduler loop, the only consumer.
+ */
+static unsigned int mDequeuePosition = 0;
+
+/*!
+ * The socket that hands the doorbell to the senders, -1 when not open.
+ */
+static int mServer = -1;
+
+static pthread_t mServerThread;
+
+static WETS_IpcEvent_t mEvents[WETS_MAX_IPC_EVENTS];
+
+/*!
+ * The function searches a binding.
+ *
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event, \ref WETS_NO_EVENT for a free binding.
+ * \return The index of the binding if it is found,
+ *         \ref WETS_MAX_IPC_EVENTS otherwise.
+ */
+static uint8_t findEvent (uint8_t priority, uint32_t event)
+{
+    for (uint8_t i = 0; i < WETS_MAX_IPC_EVENTS; ++i)
+    {
+        if ((mEvents[i].event == event) &&
+            ((event == WETS_NO_EVENT) || (mEvents[i].priority == priority)))
+        {
+            return i;
+        }
+    }
+    return WETS_MAX_IPC_EVENTS;
+}
+
+/*!
+ * The function builds the abstract socket address of a bus.
+ *
+ * \param[in]     name: The name of the bus.
+ * \param[out] address: The socket address.
+ * \return The size of the address.
+ */
+static socklen_t getServerAddress (const char* name, struct sockaddr_un* address)
+{
+    memset(address,0,sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    // The first byte is 0: the address isn't a file
+    int length = snprintf(&address->sun_path[1],sizeof(address->sun_path) - 1,"wets-ipc%s",name);
+    return (socklen_t)(offsetof(struct sockaddr_un,sun_path) + 1 + length);
+}
+
+/*!
+ * The body of the thread that passes the doorbell to each sender with
+ * SCM_RIGHTS. Only the processes of the same user get it, like the shared
+ * memory created with mode 0600.
+ */
+static void* serveDoorbell (void* arg)
+{
+    int doorbell = (int)(intptr_t)arg;
+
+    for (;;)
+    {
+        int client = accept(mServer,NULL,NULL);
+        if (client < 0)
+        {
+            if ((errno == EINTR) || (errno == ECONNABORTED))
+            {
+                continue;
+            }
+            // The socket was shut down by WETS_closeIpcBus
+            break;
+        }
+
+        struct ucred credentials;
+        socklen_t size = sizeof(credentials);
+        if ((getsockopt(client,SOL_SOCKET,SO_PEERCRED,&credentials,&size) == 0) &&
+            (credentials.uid == getuid()))
+        {
+            union
+            {
+                struct cmsghdr header;
+                char           buffer[CMSG_SPACE(sizeof(int))];
+            } control;
+            char tag = 'W';
+            struct iovec data = { .iov_base = &tag, .iov_len = 1 };
+            struct msghdr message =
+            {
+                .msg_iov        = &data,
+                .msg_iovlen     = 1,
+                .msg_control    = control.buffer,
+                .msg_controllen = sizeof(control.buffer),
+            };
+            struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type  = SCM_RIGHTS;
+            header->cmsg_len   = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(header),&doorbell,sizeof(int));
+
+            (void)sendmsg(client,&message,MSG_NOSIGNAL);
+        }
+        close(client);
+    }
+    return NULL;
+}
+
+/*!
+ * The function starts the socket and the thread that pass the doorbell.
+ *
+ * \param[in]     name: The name of the bus.
+ * \param[in] doorbell: The eventfd of the receiver.
+ * \return TRUE on success, FALSE otherwise.
+ */
+static bool openServer (const char* name, int doorbell)
+{
+    struct sockaddr_un address;
+    socklen_t length = getServerAddress(name,&address);
+
+    mServer = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+    if (mServer < 0)
+    {
+        return FALSE;
+    }
+
+    if ((bind(mServer,(struct sockaddr*)&address,length) != 0) ||
+        (listen(mServer,8) != 0) ||
+        (pthread_create(&mServerThread,NULL,serveDoorbell,(void*)(intptr_t)doorbell) != 0))
+    {
+        close(mServer);
+        mServer = -1;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*!
+ * The function stops the thread that passes the doorbell.
+ */
+static void closeServer (void)
+{
+    if (mServer >= 0)
+    {
+        // Wake-up the accept
+        shutdown(mServer,SHUT_RDWR);
+        pthread_join(mServerThread,NULL);
+        close(mServer);
+        mServer = -1;
+    }
+}
+
+/*!
+ * The function receives the doorbell from the receiver of a bus.
+ *
+ * \param[in] name: The name of the bus.
+ * \return The eventfd, -1 on failure.
+ */
+static int receiveDoorbell (const char* name)
+{
+    struct sockaddr_un address;
+    socklen_t length = getServerAddress(name,&address);
+    int doorbell = -1;
+
+    int fd = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (connect(fd,(struct sockaddr*)&address,length) == 0)
+    {
+        union
+        {
+            struct cmsghdr header;
+            char           buffer[CMSG_SPACE(sizeof(int))];
+        } control;
+        char tag;
+        struct iovec data = { .iov_base = &tag, .iov_len = 1 };
+        struct msghdr message =
+        {
+            .msg_iov        = &data,
+            .msg_iovlen     = 1,
+            .msg_control    = control.buffer,
+            .msg_controllen = sizeof(control.buffer),
+        };
+
+        if (recvmsg(fd,&message,MSG_CMSG_CLOEXEC) == 1)
+        {
+            struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+            if ((header != NULL) &&
+                (header->cmsg_level == SOL_SOCKET) &&
+                (header->cmsg_type == SCM_RIGHTS) &&
+                (header->cmsg_len == CMSG_LEN(sizeof(int))))
+            {
+                memcpy(&doorbell,CMSG_DATA(header),sizeof(int));
+            }
+        }
+    }
+    close(fd);
+    return doorbell;
+}
+
+WETS_Error_t WETS_openIpcBus (const char* name)
+{
+    if ((name == NULL) || (strlen(name) >= sizeof(mName)))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    WETS_closeIpcBus();
+
+    int doorbell = WETS_getIoDoorbell();
+    if (doorbell < 0)
+    {
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    int fd = shm_open(name,O_CREAT | O_RDWR,0600);
+    if (fd < 0)
+    {
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    // Drop the content left by a previous receiver
+    if ((ftruncate(fd,0) != 0) || (ftruncate(fd,sizeof(WETS_IpcRing_t)) != 0))
+    {
+        close(fd);
+        shm_unlink(name);
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    void* page = mmap(NULL,sizeof(WETS_IpcRing_t),PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    // The mapping remains valid without the descriptor
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    WETS_IpcRing_t* ring = (WETS_IpcRing_t*)page;
+    ring->version  = WETS_IPC_VERSION;
+    ring->size     = WETS_IPC_QUEUE_SIZE;
+    ring->pid      = (int32_t)getpid();
+    for (unsigned int i = 0; i < WETS_IPC_QUEUE_SIZE; ++i)
+    {
+        atomic_store_explicit(&ring->cells[i].sequence,i,memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring->enqueue,0u,memory_order_relaxed);
+    atomic_store_explicit(&ring->sleeping,1u,memory_order_relaxed);
+    atomic_store_explicit(&ring->open,1u,memory_order_relaxed);
+
+    if (!openServer(name,doorbell))
+    {
+        munmap(page,sizeof(WETS_IpcRing_t));
+        shm_unlink(name);
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    // The senders can connect from now
+    atomic_store_explicit(&ring->magic,WETS_IPC_MAGIC,memory_order_release);
+
+    strcpy(mName,name);
+    mDequeuePosition = 0;
+    mRing = ring;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_closeIpcBus (void)
+{
+    if (mRing != NULL)
+    {
+        atomic_store_explicit(&mRing->open,0u,memory_order_release);
+
+        closeServer();
+        munmap(mRing,sizeof(WETS_IpcRing_t));
+        shm_unlink(mName);
+        mName[0] = '\0';
+        mRing = NULL;
+    }
+}
+
+WETS_Error_t WETS_addIpcEvent (pEventCallback cb, uint8_t priority, uint32_t event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(cb != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        uint8_t i = findEvent(priority,event);
+        if (i == WETS_MAX_IPC_EVENTS)
+        {
+            i = findEvent(priority,WETS_NO_EVENT);
+            if (i == WETS_MAX_IPC_EVENTS)
+            {
+                return WETS_ERROR_NO_IPC_AVAILABLE;
+            }
+        }
+
+        mEvents[i].cb       = cb;
+        mEvents[i].priority = priority;
+        mEvents[i].event    = event;
+
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+WETS_Error_t WETS_removeIpcEvent (uint8_t priority, uint32_t event)
+{
+    uint8_t i = findEvent(priority,event);
+
+    if ((event == WETS_NO_EVENT) || (i == WETS_MAX_IPC_EVENTS))
+    {
+        return WETS_ERROR_NO_IPC_FOUND;
+    }
+
+    mEvents[i].cb       = NULL;
+    mEvents[i].priority = WETS_NO_PRIORITY;
+    mEvents[i].event    = WETS_NO_EVENT;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_removeAllIpcEvents (void)
+{
+    for (uint8_t i = 0; i < WETS_MAX_IPC_EVENTS; ++i)
+    {
+        mEvents[i].cb       = NULL;
+        mEvents[i].priority = WETS_NO_PRIORITY;
+        mEvents[i].event    = WETS_NO_EVENT;
+    }
+}
+
+/*!
+ * The function checks whether the next cell was published by a sender.
+ */
+static bool isCellReady (void)
+{
+    WETS_IpcCell_t* cell = &mRing->cells[mDequeuePosition & WETS_IPC_QUEUE_MASK];
+    unsigned int sequence = atomic_load_explicit(&cell->sequence,memory_order_acquire);
+
+    return ((int)(sequence - (mDequeuePosition + 1u)) >= 0);
+}
+
+uint16_t WETS_drainIpcEvents (void)
+{
+    uint16_t count = 0;
+
+    if (mRing == NULL)
+    {
+        return 0;
+    }
+
+    // The senders don't need to ring while the queue is drained
+    atomic_store_explicit(&mRing->sleeping,0u,memory_order_seq_cst);
+
+    while (count < WETS_IPC_QUEUE_BATCH)
+    {
+        if (!isCellReady())
+        {
+            // Ask for the doorbell, then check again for a sender that
+            // published before seeing the request
+            atomic_store_explicit(&mRing->sleeping,1u,memory_order_seq_cst);
+            if (!isCellReady())
+            {
+                break;
+            }
+            atomic_store_explicit(&mRing->sleeping,0u,memory_order_seq_cst);
+        }
+
+        WETS_IpcCell_t* cell = &mRing->cells[mDequeuePosition & WETS_IPC_QUEUE_MASK];
+        uint8_t i = findEvent(cell->priority,cell->event);
+        if ((cell->event != WETS_NO_EVENT) && (i < WETS_MAX_IPC_EVENTS))
+        {
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+            WETS_Error_t err = WETS_addPayloadEvent(mEvents[i].cb,cell->priority,cell->event,(uintptr_t)cell->payload);
+#else
+            WETS_Error_t err = WETS_addEvent(mEvents[i].cb,cell->priority,cell->event);
+#endif
+            if (err == WETS_ERROR_EVENT_RETRY)
+            {
+                // The group is full: the cell is kept and tried again at the
+                // next drain, the senders see the queue full meanwhile
+                break;
+            }
+        }
+
+        // Give the cell back to the senders for the next lap
+        atomic_store_explicit(&cell->sequence,
+                              mDequeuePosition + WETS_IPC_QUEUE_SIZE,
+                              memory_order_release);
+        mDequeuePosition++;
+        count++;
+    }
+    return count;
+}
+
+WETS_Error_t WETS_connectIpcBus (const char* name, WETS_IpcPeer_t* peer)
+{
+    if ((name == NULL) || (peer == NULL) || (strlen(name) >= sizeof(mName)))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    peer->ring     = NULL;
+    peer->doorbell = -1;
+
+    int fd = shm_open(name,O_RDWR,0);
+    if (fd < 0)
+    {
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    struct stat info;
+    if ((fstat(fd,&info) != 0) || ((size_t)info.st_size < sizeof(WETS_IpcRing_t)))
+    {
+        close(fd);
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    void* page = mmap(NULL,sizeof(WETS_IpcRing_t),PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    WETS_IpcRing_t* ring = (WETS_IpcRing_t*)page;
+    if ((atomic_load_explicit(&ring->magic,memory_order_acquire) != WETS_IPC_MAGIC) ||
+        (ring->version != WETS_IPC_VERSION) ||
+        (ring->size != WETS_IPC_QUEUE_SIZE))
+    {
+        munmap(page,sizeof(WETS_IpcRing_t));
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    // Get a copy of the eventfd of the receiver
+    int doorbell = receiveDoorbell(name);
+    if (doorbell < 0)
+    {
+        munmap(page,sizeof(WETS_IpcRing_t));
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    peer->ring     = page;
+    peer->doorbell = doorbell;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_disconnectIpcBus (WETS_IpcPeer_t* peer)
+{
+    if ((peer != NULL) && (peer->ring != NULL))
+    {
+        munmap(peer->ring,sizeof(WETS_IpcRing_t));
+        close(peer->doorbell);
+        peer->ring     = NULL;
+        peer->doorbell = -1;
+    }
+}
+
+WETS_Error_t WETS_sendIpcEvent (WETS_IpcPeer_t* peer,
+                                uint8_t priority,
+                                uint32_t event,
+                                uint64_t payload)
+{
+    if ((peer == NULL) || (peer->ring == NULL) ||
+        (event == 0ul) || (priority >= WETS_MAX_PRIORITY_LEVEL))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    WETS_IpcRing_t* ring = (WETS_IpcRing_t*)peer->ring;
+    if (atomic_load_explicit(&ring->open,memory_order_acquire) == 0u)
+    {
+        return WETS_ERROR_IPC_FAILED;
+    }
+
+    WETS_IpcCell_t* cell = NULL;
+    unsigned int position = atomic_load_explicit(&ring->enqueue,memory_order_relaxed);
+
+    for (;;)
+    {
+        cell = &ring->cells[position & WETS_IPC_QUEUE_MASK];
+        unsigned int sequence = atomic_load_explicit(&cell->sequence,memory_order_acquire);
+        int diff = (int)(sequence - position);
+
+        if (diff == 0)
+        {
+            // The cell is free, try to reserve it
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue,
+                                                      &position,
+                                                      position + 1u,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The receiver has not read the cell yet: the queue is full
+            return WETS_ERROR_IPC_QUEUE_FULL;
+        }
+        else
+        {
+            // Another sender took the cell
+            position = atomic_load_explicit(&ring->enqueue,memory_order_relaxed);
+        }
+    }
+
+    cell->priority = priority;
+    cell->event    = event;
+    cell->payload  = payload;
+    // Publish the cell to the receiver
+    atomic_store_explicit(&cell->sequence,position + 1u,memory_order_seq_cst);
+
+    // Only the first sender after the receiver went idle pays the system call
+    if (atomic_exchange_explicit(&ring->sleeping,0u,memory_order_seq_cst) != 0u)
+    {
+        uint64_t value = 1;
+        (void)write(peer->doorbell,&value,sizeof(value));
+    }
+
+    return WETS_ERROR_SUCCESS;
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_IPC
@@ -0,0 +1,214 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-ipc.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_IPC_H
+#define __WARCOMEB_WETS_IPC_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_IpcBus WETS Inter-Process Events Management
+ * \ingroup  WETS
+ * \{
+ *
+ * The bus lets a process send events to the scheduler of another process.
+ * The receiver opens a POSIX shared memory object that holds a bounded
+ * lock-free multi-producer single-consumer queue; the senders map it and
+ * write (priority, event, payload) without any system call, then ring the
+ * eventfd that wakes-up the idle wait of the receiver only when it sleeps.
+ * The eventfd is passed to each sender with SCM_RIGHTS over an abstract
+ * UNIX socket named after the bus, served by a thread of the receiver; only
+ * the processes of the same user get it.
+ *
+ * The shared memory has the same layout in 32 and 64 bit processes. It
+ * requires \ref WETS_USE_IO_SOURCES, whose idle wait listens to the
+ * eventfd.
+ *
+ * The callbacks can't cross the process boundary: the receiver binds each
+ * (priority, event) to a local callback with \ref WETS_addIpcEvent, and the
+ * events without a binding are discarded.
+ */
+
+/*!
+ * The number of cells of the queue, must be a power of two.
+ */
+#if !defined (WETS_IPC_QUEUE_SIZE)
+#define WETS_IPC_QUEUE_SIZE                      256u
+#endif
+
+/*!
+ * The maximum number of events moved into the tables at each iteration.
+ */
+#if !defined (WETS_IPC_QUEUE_BATCH)
+#define WETS_IPC_QUEUE_BATCH                     WETS_IPC_QUEUE_SIZE
+#endif
+
+/*!
+ * The maximum number of events that the receiver can bind.
+ */
+#if !defined (WETS_MAX_IPC_EVENTS)
+#define WETS_MAX_IPC_EVENTS                      16u
+#endif
+
+/*!
+ * The sender side of a bus.
+ */
+typedef struct _WETS_IpcPeer
+{
+    /*!< The shared memory of the receiver, NULL when not connected. */
+    void* ring;
+
+    /*!< The eventfd of the receiver. */
+    int   doorbell;
+
+} WETS_IpcPeer_t;
+
+/*!
+ * This function creates the bus of this process with the given name. The
+ * name follows the rules of shm_open(), like "/wets-motor".
+ *
+ * \param[in] name: The name of the bus.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the bus was created.
+ *         \arg \ref WETS_ERROR_IPC_FAILED when the shared memory, the
+ *                   eventfd or its socket can't be created.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_openIpcBus (const char* name);
+
+/*!
+ * This function removes the bus of this process. The connected senders
+ * will fail with \ref WETS_ERROR_IPC_FAILED.
+ */
+void WETS_closeIpcBus (void);
+
+/*!
+ * This function binds an event received from the bus to a local callback.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the binding was created.
+ *         \arg \ref WETS_ERROR_NO_IPC_AVAILABLE when there isn't space for
+ *                   the new binding.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_addIpcEvent (pEventCallback cb, uint8_t priority, uint32_t event);
+
+/*!
+ * This function removes the binding of an event.
+ *
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the binding was removed.
+ *         \arg \ref WETS_ERROR_NO_IPC_FOUND when the binding was not found.
+ */
+WETS_Error_t WETS_removeIpcEvent (uint8_t priority, uint32_t event);
+
+/*!
+ * This function clear all bindings.
+ */
+void WETS_removeAllIpcEvents (void);
+
+/*!
+ * This function it is called inside the main loop of the scheduler
+ * (\ref WETS_loop()) to move at most \ref WETS_IPC_QUEUE_BATCH received
+ * events into the event tables. When a group refuses an event with
+ * \ref WETS_ERROR_EVENT_RETRY, the event stays at the head of the queue and
+ * the drain stops until the next call.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \return The number of events moved.
+ */
+uint16_t WETS_drainIpcEvents (void);
+
+/*!
+ * This function connects to the bus of another process.
+ *
+ * \param[in]  name: The name of the bus.
+ * \param[out] peer: The sender side of the bus.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the peer is connected.
+ *         \arg \ref WETS_ERROR_IPC_FAILED when the bus doesn't exist or its
+ *                   eventfd can't be taken.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_connectIpcBus (const char* name, WETS_IpcPeer_t* peer);
+
+/*!
+ * This function releases the sender side of a bus.
+ *
+ * \param[in] peer: The sender side of the bus.
+ */
+void WETS_disconnectIpcBus (WETS_IpcPeer_t* peer);
+
+/*!
+ * This function sends an event to the scheduler of another process. It can
+ * be called from any thread.
+ *
+ * \param[in]     peer: The sender side of the bus.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event, see
+ *                      \ref WETS_getEventPayload.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the event was queued.
+ *         \arg \ref WETS_ERROR_IPC_QUEUE_FULL when the queue has no free
+ *                   cells.
+ *         \arg \ref WETS_ERROR_IPC_FAILED when the bus was closed.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_sendIpcEvent (WETS_IpcPeer_t* peer,
+                                uint8_t priority,
+                                uint32_t event,
+                                uint64_t payload);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_IPC_H
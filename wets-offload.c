@@ -0,0 +1,227 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-offload.c
+ * \brief
+ */
+
+#include "wets-offload.h"
+#include "wets-post.h"
+
+#if (WETS_USE_OFFLOAD == 1)
+
+#if (WETS_USE_POST_QUEUE != 1)
+#error "WETS_USE_OFFLOAD requires WETS_USE_POST_QUEUE"
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_OffloadEvent
+ * \{
+ */
+
+/*!
+ * A job class.
+ */
+typedef struct _WETS_OffloadJob
+{
+    /*!< The event priority. */
+    uint8_t priority;
+
+    /*!< The event flag posted when the job ends. */
+    uint32_t event;
+
+    /*!< The function executed by the worker. */
+    pEventCallback job;
+
+    /*!< The callback that will be called when the event is fired. */
+    pEventCallback cb;
+
+} WETS_OffloadJob_t;
+
+/*!
+ * The circular list of jobs waiting for a worker.
+ */
+static WETS_OffloadJob_t mJobs[WETS_OFFLOAD_QUEUE_SIZE];
+
+static uint8_t mJobsHead = 0;
+
+static uint8_t mJobsWaiting = 0;
+
+/*!
+ * Save the number of jobs queued or running.
+ */
+static uint8_t mJobsActive = 0;
+
+static pthread_mutex_t mJobsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_cond_t mJobsReady = PTHREAD_COND_INITIALIZER;
+
+static pthread_t mWorkers[WETS_OFFLOAD_THREADS];
+
+/*!
+ * The number of worker threads started.
+ */
+static uint8_t mWorkersCount = 0;
+
+/*!
+ * The body of the worker threads: it waits a job, runs it and posts the
+ * completion event.
+ */
+static void* worker (void* unused)
+{
+    (void)unused;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&mJobsLock);
+        while (mJobsWaiting == 0)
+        {
+            pthread_cond_wait(&mJobsReady,&mJobsLock);
+        }
+        WETS_OffloadJob_t job = mJobs[mJobsHead];
+        mJobsHead = (mJobsHead + 1) % WETS_OFFLOAD_QUEUE_SIZE;
+        mJobsWaiting--;
+        pthread_mutex_unlock(&mJobsLock);
+
+        uint32_t result = job.job(job.event);
+
+        // The completion must not be lost: wait for a free cell
+        while (WETS_postEvent(job.cb,job.priority,job.event,result) == WETS_ERROR_POST_QUEUE_FULL)
+        {
+            sched_yield();
+        }
+
+        pthread_mutex_lock(&mJobsLock);
+        mJobsActive--;
+        pthread_mutex_unlock(&mJobsLock);
+    }
+    return NULL;
+}
+
+/*!
+ * Start the worker threads at the first job. When no worker can be created
+ * the start is tried again at the next job.
+ *
+ * \note It is called with the lock of the jobs.
+ *
+ * \return TRUE when at least one worker is running, FALSE otherwise.
+ */
+static bool startPool (void)
+{
+    if (mWorkersCount > 0)
+    {
+        return TRUE;
+    }
+
+    for (uint8_t i = 0; i < WETS_OFFLOAD_THREADS; ++i)
+    {
+        if (pthread_create(&mWorkers[i],NULL,worker,NULL) != 0)
+        {
+            break;
+        }
+        pthread_detach(mWorkers[i]);
+        mWorkersCount++;
+    }
+    return (mWorkersCount > 0);
+}
+
+WETS_Error_t WETS_addOffloadEvent (pEventCallback job,
+                                   pEventCallback cb,
+                                   uint8_t priority,
+                                   uint32_t event)
+{
+    System_Errors err = ERRORS_NO_ERROR;
+
+    err |= ohiassert(event > 0ul);
+    err |= ohiassert(priority < WETS_MAX_PRIORITY_LEVEL);
+    err |= ohiassert(job != NULL);
+    err |= ohiassert(cb != NULL);
+
+    if (err == ERRORS_NO_ERROR)
+    {
+        pthread_mutex_lock(&mJobsLock);
+        if (!startPool())
+        {
+            pthread_mutex_unlock(&mJobsLock);
+            return WETS_ERROR_THREAD_FAILED;
+        }
+        if (mJobsWaiting == WETS_OFFLOAD_QUEUE_SIZE)
+        {
+            pthread_mutex_unlock(&mJobsLock);
+            return WETS_ERROR_OFFLOAD_QUEUE_FULL;
+        }
+
+        WETS_OffloadJob_t* slot = &mJobs[(mJobsHead + mJobsWaiting) % WETS_OFFLOAD_QUEUE_SIZE];
+        slot->job      = job;
+        slot->cb       = cb;
+        slot->priority = priority;
+        slot->event    = event;
+
+        mJobsWaiting++;
+        mJobsActive++;
+        pthread_cond_signal(&mJobsReady);
+        pthread_mutex_unlock(&mJobsLock);
+
+        return WETS_ERROR_SUCCESS;
+    }
+    return WETS_ERROR_WRONG_PARAMS;
+}
+
+void WETS_removeAllOffloadEvents (void)
+{
+    pthread_mutex_lock(&mJobsLock);
+    mJobsActive -= mJobsWaiting;
+    mJobsWaiting = 0;
+    mJobsHead    = 0;
+    pthread_mutex_unlock(&mJobsLock);
+}
+
+uint8_t WETS_getCurrentOffloadEventsActive (void)
+{
+    pthread_mutex_lock(&mJobsLock);
+    uint8_t active = mJobsActive;
+    pthread_mutex_unlock(&mJobsLock);
+    return active;
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_OFFLOAD
@@ -0,0 +1,110 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-offload.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_OFFLOAD_H
+#define __WARCOMEB_WETS_OFFLOAD_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_OffloadEvent WETS Offloaded Events Management
+ * \ingroup  WETS
+ * \{
+ *
+ * An offloaded event runs its job on a small pool of POSIX worker threads,
+ * so a long callback (flash write, compression...) does not block the other
+ * priorities into \ref WETS_loop(). When the job ends, its result is posted
+ * back to the scheduler as the payload of the completion event.
+ */
+
+#if !defined (WETS_OFFLOAD_THREADS)
+#define WETS_OFFLOAD_THREADS                     2u
+#endif
+
+#if !defined (WETS_OFFLOAD_QUEUE_SIZE)
+#define WETS_OFFLOAD_QUEUE_SIZE                  16u
+#endif
+
+/*!
+ * This function is called to run a job outside the scheduler loop.
+ * The job is called by a worker thread with the event as argument; when it
+ * returns, the event is posted with \ref WETS_postEvent and the value
+ * returned by the job as payload, so the callback runs into the scheduler
+ * loop and can read the result with \ref WETS_getEventPayload.
+ *
+ * \note The job runs concurrently with the scheduler: it must not call the
+ *       WETS functions other than \ref WETS_postEvent.
+ *
+ * \param[in]      job: The function to run on the worker thread.
+ * \param[in]       cb: The callback for the completion event.
+ * \param[in] priority: The priority group for the completion event.
+ * \param[in]    event: The event to be notified.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the job was queued.
+ *         \arg \ref WETS_ERROR_OFFLOAD_QUEUE_FULL when all the workers are
+ *                   busy and there isn't space for the new job.
+ *         \arg \ref WETS_ERROR_THREAD_FAILED when no worker thread can be
+ *                   started.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_addOffloadEvent (pEventCallback job,
+                                   pEventCallback cb,
+                                   uint8_t priority,
+                                   uint32_t event);
+
+/*!
+ * This function clear all the jobs that are not started yet.
+ * The running jobs will complete and post their events.
+ */
+void WETS_removeAllOffloadEvents (void);
+
+/*!
+ * This function return the number of jobs queued or running.
+ *
+ * \return The number of current jobs.
+ */
+uint8_t WETS_getCurrentOffloadEventsActive (void);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_OFFLOAD_H
@@ -0,0 +1,261 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-post.c
+ * \brief
+ */
+
+#include "wets-post.h"
+#include "wets-event.h"
+
+#if (WETS_USE_POST_QUEUE == 1)
+
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_PostEvent
+ * \{
+ */
+
+#if ((WETS_POST_QUEUE_SIZE & (WETS_POST_QUEUE_SIZE - 1u)) != 0u)
+#error "WETS_POST_QUEUE_SIZE must be a power of two"
+#endif
+
+#define WETS_POST_QUEUE_MASK                     (WETS_POST_QUEUE_SIZE - 1u)
+
+/*!
+ * A cell of the posted events queue.
+ */
+typedef struct _WETS_PostCell
+{
+    /*!< The sequence number that gives the cell ownership. */
+    atomic_uint    sequence;
+
+    /*!< The event priority. */
+    uint8_t        priority;
+
+    /*!< The event flag. */
+    uint32_t       event;
+
+    /*!< The callback that will be called when the event is fired. */
+    pEventCallback cb;
+
+    /*!< The user value attached to the event. */
+    uintptr_t      payload;
+
+} WETS_PostCell_t;
+
+/*!
+ * The queue cells.
+ */
+static WETS_PostCell_t mCells[WETS_POST_QUEUE_SIZE] WETS_CACHE_ALIGNED;
+
+/*!
+ * The next position reserved by a producer.
+ */
+static WETS_CACHE_PADDED(atomic_uint) mEnqueuePosition;
+
+/*!
+ * The next position read by the scheduler loop, the only consumer.
+ */
+static WETS_CACHE_PADDED(unsigned int) mDequeuePosition = { 0 };
+
+/*!
+ * The event refused by each group with \ref WETS_ERROR_EVENT_RETRY, moved
+ * out of the queue so that it doesn't stop the events of the other groups.
+ * A free entry has no callback, the sequence is not used.
+ */
+static WETS_PostCell_t mParked[WETS_MAX_PRIORITY_LEVEL];
+
+/*!
+ * The function moves the event of a cell into the event tables.
+ *
+ * \param[in] cell: The cell.
+ * \return The same values of \ref WETS_addEvent.
+ */
+static inline WETS_Error_t moveCell (const WETS_PostCell_t* cell)
+{
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+    return WETS_addPayloadEvent(cell->cb,cell->priority,cell->event,cell->payload);
+#else
+    return WETS_addEvent(cell->cb,cell->priority,cell->event);
+#endif
+}
+
+WETS_Error_t WETS_postEvent (pEventCallback cb,
+                             uint8_t priority,
+                             uint32_t event,
+                             uintptr_t payload)
+{
+    if ((event == 0ul) || (priority >= WETS_MAX_PRIORITY_LEVEL) || (cb == NULL))
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    WETS_PostCell_t* cell = NULL;
+    unsigned int position = atomic_load_explicit(&mEnqueuePosition.value,memory_order_relaxed);
+
+    for (;;)
+    {
+        cell = &mCells[position & WETS_POST_QUEUE_MASK];
+        unsigned int sequence = atomic_load_explicit(&cell->sequence,memory_order_acquire);
+        int diff = (int)(sequence - position);
+
+        if (diff == 0)
+        {
+            // The cell is free, try to reserve it
+            if (atomic_compare_exchange_weak_explicit(&mEnqueuePosition.value,
+                                                      &position,
+                                                      position + 1u,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The consumer has not read the cell yet: the queue is full
+            return WETS_ERROR_POST_QUEUE_FULL;
+        }
+        else
+        {
+            // Another producer took the cell
+            position = atomic_load_explicit(&mEnqueuePosition.value,memory_order_relaxed);
+        }
+    }
+
+    cell->cb       = cb;
+    cell->priority = priority;
+    cell->event    = event;
+    cell->payload  = payload;
+    // Publish the cell to the consumer
+    atomic_store_explicit(&cell->sequence,position + 1u,memory_order_release);
+
+    WETS_doAfterPost();
+
+    return WETS_ERROR_SUCCESS;
+}
+
+uint16_t WETS_drainPostedEvents (void)
+{
+    uint16_t count = 0;
+    uint16_t taken = 0;
+
+    // The parked events first, they were posted before the queued ones
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        if ((mParked[i].cb != NULL) &&
+            (moveCell(&mParked[i]) != WETS_ERROR_EVENT_RETRY))
+        {
+            mParked[i].cb = NULL;
+            count++;
+        }
+    }
+
+    while (taken < WETS_POST_QUEUE_BATCH)
+    {
+        WETS_PostCell_t* cell = &mCells[mDequeuePosition.value & WETS_POST_QUEUE_MASK];
+        unsigned int sequence = atomic_load_explicit(&cell->sequence,memory_order_acquire);
+
+        if ((int)(sequence - (mDequeuePosition.value + 1u)) < 0)
+        {
+            // Empty queue, or the producer is still writing the cell
+            break;
+        }
+
+        WETS_PostCell_t* parked = &mParked[cell->priority];
+        if (parked->cb != NULL)
+        {
+            // The group has already refused an event: the cell waits at the
+            // head of the queue, to keep the order of the group, and the
+            // producers see the queue full meanwhile
+            break;
+        }
+
+        WETS_Error_t err = moveCell(cell);
+        if (err == WETS_ERROR_EVENT_RETRY)
+        {
+            // The group is full: the event is parked and tried again at the
+            // next drain, the other groups go on
+            parked->priority = cell->priority;
+            parked->event    = cell->event;
+            parked->cb       = cell->cb;
+            parked->payload  = cell->payload;
+        }
+        else
+        {
+            count++;
+        }
+
+        // Give the cell back to the producers for the next lap
+        atomic_store_explicit(&cell->sequence,
+                              mDequeuePosition.value + WETS_POST_QUEUE_SIZE,
+                              memory_order_release);
+        mDequeuePosition.value++;
+        taken++;
+    }
+    return count;
+}
+
+void WETS_removeAllPostedEvents (void)
+{
+    for (unsigned int i = 0; i < WETS_POST_QUEUE_SIZE; ++i)
+    {
+        mCells[i].cb       = NULL;
+        mCells[i].priority = WETS_NO_PRIORITY;
+        mCells[i].event    = WETS_NO_EVENT;
+        mCells[i].payload  = 0;
+        atomic_store_explicit(&mCells[i].sequence,i,memory_order_relaxed);
+    }
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        mParked[i].cb = NULL;
+    }
+    mDequeuePosition.value = 0;
+    atomic_store_explicit(&mEnqueuePosition.value,0u,memory_order_release);
+}
+
+_weak void WETS_doAfterPost (void)
+{
+    // WARNING: Could be implemented to wake-up the scheduler
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_POST_QUEUE
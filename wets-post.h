@@ -0,0 +1,120 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-post.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_POST_H
+#define __WARCOMEB_WETS_POST_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_PostEvent WETS Posted Events Management
+ * \ingroup  WETS
+ * \{
+ *
+ * The posted events are a bounded lock-free multi-producer single-consumer
+ * queue: every thread (or interrupt) can post an event without taking the
+ * scheduler critical section, and \ref WETS_loop() moves them into the event
+ * tables in batches at the top of each iteration.
+ */
+
+#if !defined (WETS_POST_QUEUE_SIZE)
+#define WETS_POST_QUEUE_SIZE                     256u
+#endif
+
+#if !defined (WETS_POST_QUEUE_BATCH)
+#define WETS_POST_QUEUE_BATCH                    WETS_POST_QUEUE_SIZE
+#endif
+
+/*!
+ * This function is called to post an event from any thread. The event will
+ * be added by the scheduler loop as with \ref WETS_addPayloadEvent.
+ *
+ * \param[in]       cb: The callback for the event.
+ * \param[in] priority: The priority group for the event.
+ * \param[in]    event: The event to be notified.
+ * \param[in]  payload: The value attached to the event, discarded when
+ *                      \ref WETS_USE_EVENT_PAYLOAD is not enabled.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the event was queued.
+ *         \arg \ref WETS_ERROR_POST_QUEUE_FULL when the queue has no free
+ *                   cells.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_postEvent (pEventCallback cb,
+                             uint8_t priority,
+                             uint32_t event,
+                             uintptr_t payload);
+
+/*!
+ * This function it is called inside the main loop of the scheduler
+ * (\ref WETS_loop()) to move at most \ref WETS_POST_QUEUE_BATCH posted events
+ * into the event tables. When a group refuses an event with
+ * \ref WETS_ERROR_EVENT_RETRY, the event is parked out of the queue and
+ * tried again, before the queued ones, at the next call, while the events
+ * of the other groups go on. Each group parks one event: when the next
+ * event at the head of the queue belongs to a group that already parked
+ * one, it stays there to keep the order of the group, and the drain stops
+ * until the next call.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \return The number of events moved.
+ */
+uint16_t WETS_drainPostedEvents (void);
+
+/*!
+ * This function clear all posted events and reset the queue.
+ *
+ * \note It must be called when no producer is posting.
+ */
+void WETS_removeAllPostedEvents (void);
+
+/*!
+ * This function is called every time an event is posted, by the producer
+ * thread. The user can implement it to wake-up the scheduler loop.
+ */
+void WETS_doAfterPost (void);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_POST_H
@@ -0,0 +1,104 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-profile.c
+ * \brief
+ */
+
+#include "wets-profile.h"
+
+#if (WETS_USE_PROFILING == 1) && (WETS_PROFILE_USE_REFERENCE == 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_Profile
+ * \{
+ */
+
+/*!
+ * The aggregated data of each site.
+ */
+static WETS_Profile_t mProfiles[WETS_PROFILE_SITE_NUMBER];
+
+/*!
+ * The timestamp of the last entry into each site.
+ *
+ * \note A site can't be nested: an interrupt that calls \ref WETS_addEvent
+ *       while the loop is into the same function spoils one sample.
+ */
+static uint32_t mBegin[WETS_PROFILE_SITE_NUMBER];
+
+void WETS_profileBegin (WETS_ProfileSite_t site, uint32_t timestamp)
+{
+    mBegin[site] = timestamp;
+}
+
+void WETS_profileEnd (WETS_ProfileSite_t site, uint32_t timestamp)
+{
+    // The difference is correct also when the counter wraps around
+    uint32_t duration = timestamp - mBegin[site];
+
+    mProfiles[site].count++;
+    mProfiles[site].total += duration;
+    if (duration > mProfiles[site].max)
+    {
+        mProfiles[site].max = duration;
+    }
+}
+
+const WETS_Profile_t* WETS_getProfile (WETS_ProfileSite_t site)
+{
+    if (site < WETS_PROFILE_SITE_NUMBER)
+    {
+        return &mProfiles[site];
+    }
+    return NULL;
+}
+
+void WETS_clearProfiles (void)
+{
+    for (uint8_t i = 0; i < WETS_PROFILE_SITE_NUMBER; ++i)
+    {
+        mProfiles[i].count = 0;
+        mProfiles[i].total = 0;
+        mProfiles[i].max   = 0;
+    }
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_PROFILING
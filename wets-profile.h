@@ -0,0 +1,171 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-profile.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_PROFILE_H
+#define __WARCOMEB_WETS_PROFILE_H
+
+#include "wets-types.h"
+
+#if (WETS_USE_PROFILING == 1) && !defined (WETS_PROFILE_TIMESTAMP)
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#elif !defined (__ARM_ARCH_7M__) && !defined (__ARM_ARCH_7EM__) && !defined (__ARM_ARCH_8M_MAIN__)
+#include <time.h>
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_Profile WETS Profiling Hooks
+ * \ingroup  WETS
+ * \{
+ *
+ * The scheduler calls \ref WETS_PROFILE_BEGIN and \ref WETS_PROFILE_END at
+ * every interesting point. The hooks are compiled out unless
+ * \ref WETS_USE_PROFILING is enabled, so they cost nothing by default.
+ *
+ * The timestamp source is \ref WETS_PROFILE_TIMESTAMP: by default it is the
+ * TSC on x86, the DWT cycle counter on Cortex-M (the user must enable the
+ * counter) and clock_gettime() on the other POSIX hosts; it can be replaced
+ * by defining the macro at build time.
+ * The reference backend aggregates count, total and longest duration of
+ * each site; disable \ref WETS_PROFILE_USE_REFERENCE to implement
+ * \ref WETS_profileBegin and \ref WETS_profileEnd in the application.
+ */
+
+#if !defined (WETS_PROFILE_USE_REFERENCE)
+#define WETS_PROFILE_USE_REFERENCE               1u
+#endif
+
+/*!
+ * List of all profiled sites.
+ */
+typedef enum _WETS_ProfileSite
+{
+    WETS_PROFILE_SITE_ADD_EVENT = 0,
+    WETS_PROFILE_SITE_DISPATCH,
+    WETS_PROFILE_SITE_UPDATE_DELAY,
+    WETS_PROFILE_SITE_UPDATE_CYCLIC,
+    WETS_PROFILE_SITE_BEFORE_SLEEP,
+    WETS_PROFILE_SITE_AFTER_WAKEUP,
+    WETS_PROFILE_SITE_TIMER_ISR,
+
+    WETS_PROFILE_SITE_NUMBER,
+} WETS_ProfileSite_t;
+
+#if (WETS_USE_PROFILING == 1)
+
+#if !defined (WETS_PROFILE_TIMESTAMP)
+#if defined (__x86_64__) || defined (__i386__)
+#define WETS_PROFILE_TIMESTAMP()                 ((uint32_t)__rdtsc())
+#elif defined (__ARM_ARCH_7M__) || defined (__ARM_ARCH_7EM__) || defined (__ARM_ARCH_8M_MAIN__)
+#define WETS_PROFILE_TIMESTAMP()                 (*((volatile uint32_t*)0xE0001004ul))
+#else
+static inline uint32_t WETS_getProfileTimestamp (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+#define WETS_PROFILE_TIMESTAMP()                 WETS_getProfileTimestamp()
+#endif
+#endif
+
+#define WETS_PROFILE_BEGIN(site)                 WETS_profileBegin(site,WETS_PROFILE_TIMESTAMP())
+#define WETS_PROFILE_END(site)                   WETS_profileEnd(site,WETS_PROFILE_TIMESTAMP())
+
+/*!
+ * This function is called when the scheduler enters a profiled site.
+ *
+ * \param[in]      site: The profiled site.
+ * \param[in] timestamp: The value of \ref WETS_PROFILE_TIMESTAMP.
+ */
+void WETS_profileBegin (WETS_ProfileSite_t site, uint32_t timestamp);
+
+/*!
+ * This function is called when the scheduler leaves a profiled site.
+ *
+ * \param[in]      site: The profiled site.
+ * \param[in] timestamp: The value of \ref WETS_PROFILE_TIMESTAMP.
+ */
+void WETS_profileEnd (WETS_ProfileSite_t site, uint32_t timestamp);
+
+#if (WETS_PROFILE_USE_REFERENCE == 1)
+/*!
+ * The aggregated durations of a site, in \ref WETS_PROFILE_TIMESTAMP units.
+ */
+typedef struct _WETS_Profile
+{
+    /*!< The number of executions. */
+    uint32_t count;
+
+    /*!< The sum of the durations. */
+    uint64_t total;
+
+    /*!< The longest duration. */
+    uint32_t max;
+
+} WETS_Profile_t;
+
+/*!
+ * This function returns the aggregated durations of a site.
+ *
+ * \param[in] site: The profiled site.
+ * \return The pointer to the site data, NULL when the site is not valid.
+ */
+const WETS_Profile_t* WETS_getProfile (WETS_ProfileSite_t site);
+
+/*!
+ * This function clear the data of all sites.
+ */
+void WETS_clearProfiles (void);
+#endif
+
+#else
+
+#define WETS_PROFILE_BEGIN(site)
+#define WETS_PROFILE_END(site)
+
+#endif // WETS_USE_PROFILING
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_PROFILE_H
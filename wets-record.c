@@ -0,0 +1,163 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-record.c
+ * \brief
+ */
+
+#include "wets-record.h"
+#include "wets-event.h"
+
+#if (WETS_USE_RECORDER == 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_Recorder
+ * \{
+ */
+
+/*!
+ * The current sink, NULL when the recorder is stopped.
+ */
+static volatile pRecordSink mSink = NULL;
+
+static uint8_t* putU32 (uint8_t* data, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        *data++ = (uint8_t)(value >> (8 * i));
+    }
+    return data;
+}
+
+void WETS_startRecorder (pRecordSink sink)
+{
+    uint8_t header[WETS_RECORD_HEADER_SIZE] = { 'W', 'R', 'E', 'C', WETS_RECORD_VERSION };
+    uint8_t* data = &header[5];
+
+    if (sink == NULL)
+    {
+        return;
+    }
+
+    data = putU32(data,WETS_ISR_PERIOD_ms);
+    putU32(data,WETS_getCurrentTime());
+
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    sink(header,WETS_RECORD_HEADER_SIZE);
+    mSink = sink;
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+}
+
+void WETS_stopRecorder (void)
+{
+    mSink = NULL;
+}
+
+/*!
+ * The function writes a record to the sink.
+ *
+ * \param[in]     kind: The record kind.
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The event.
+ * \param[in]   values: The values of the kind.
+ * \param[in]    count: The number of values, from 0 to 2.
+ */
+static void writeRecord (WETS_RecordKind_t kind,
+                         uint8_t priority,
+                         uint32_t event,
+                         const uint32_t* values,
+                         uint8_t count)
+{
+    uint8_t record[WETS_RECORD_CYCLIC_SIZE];
+    uint8_t* data = record;
+
+    if (mSink == NULL)
+    {
+        return;
+    }
+
+    *data++ = (uint8_t)kind;
+    *data++ = priority;
+    data = putU32(data,WETS_getCurrentTime());
+    data = putU32(data,event);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        data = putU32(data,values[i]);
+    }
+
+    // The records of concurrent producers must not be mixed
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_BEGIN();
+#endif
+    pRecordSink sink = mSink;
+    if (sink != NULL)
+    {
+        sink(record,(uint8_t)(data - record));
+    }
+#if (WETS_USE_CRITICAL_SECTION == 1)
+    CRITICAL_SECTION_END();
+#endif
+}
+
+void WETS_record (WETS_RecordKind_t kind, uint8_t priority, uint32_t event, uint32_t value)
+{
+    uint8_t count = 1;
+
+    if ((kind == WETS_RECORD_EVENT) ||
+        (kind == WETS_RECORD_REMOVE_DELAY) ||
+        (kind == WETS_RECORD_REMOVE_CYCLIC))
+    {
+        count = 0;
+    }
+    writeRecord(kind,priority,event,&value,count);
+}
+
+void WETS_recordCyclic (uint8_t priority, uint32_t event, uint32_t period, uint32_t phase)
+{
+    uint32_t values[2] = { period, phase };
+
+    writeRecord(WETS_RECORD_CYCLIC,priority,event,values,2);
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_RECORDER
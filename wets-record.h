@@ -0,0 +1,157 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-record.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_RECORD_H
+#define __WARCOMEB_WETS_RECORD_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_Recorder WETS Event Recorder
+ * \ingroup  WETS
+ * \{
+ *
+ * The recorder writes a record for each event posted with
+ * \ref WETS_addEvent or \ref WETS_addPayloadEvent, also when the group
+ * refuses it, and for each delayed or cyclic timer added, re-armed, changed
+ * or removed, with the time of the scheduler.
+ * The events posted by the expired timers are not recorded, they are
+ * generated again when the timers are replayed.
+ *
+ * The records are passed to a sink of the application, that can copy them
+ * into a memory-mapped file or send them over a port. The stream starts
+ * with a header of \ref WETS_RECORD_HEADER_SIZE bytes: "WREC", the version,
+ * the tick period and the start time. Then each record is made of the kind,
+ * the priority, the time and the event, followed by a value for the kinds
+ * that have one, or by the period and the phase for the cyclic events; all
+ * fields are little-endian.
+ *
+ * The tool tools/wets-replay.c feeds a stream back into the scheduler on the
+ * host and reports dispatch latency and throughput.
+ *
+ * \note The sink is called by the function that posts the event, also from
+ *       an interrupt, so it must only copy the record.
+ */
+
+/*!
+ * The version of the stream format.
+ */
+#define WETS_RECORD_VERSION                      2u
+
+/*!
+ * The size of the stream header.
+ */
+#define WETS_RECORD_HEADER_SIZE                  13u
+
+/*!
+ * The size of a record without value, of a record with value and of a
+ * record with period and phase.
+ */
+#define WETS_RECORD_SIZE                         10u
+#define WETS_RECORD_VALUE_SIZE                   14u
+#define WETS_RECORD_CYCLIC_SIZE                  18u
+
+/*!
+ * List of all record kinds.
+ */
+typedef enum _WETS_RecordKind
+{
+    WETS_RECORD_EVENT = 1,     /*!< An event, no value. */
+    WETS_RECORD_PAYLOAD_EVENT, /*!< An event, the value is the payload. */
+    WETS_RECORD_DELAY,         /*!< A delayed event, the value is the timeout. */
+    WETS_RECORD_EDIT_DELAY,    /*!< A new timeout, the value is the timeout. */
+    WETS_RECORD_REMOVE_DELAY,  /*!< A delayed event removed, no value. */
+    WETS_RECORD_CYCLIC,        /*!< A cyclic event, the period and the phase. */
+    WETS_RECORD_EDIT_CYCLIC,   /*!< A new period, the value is the period. */
+    WETS_RECORD_REMOVE_CYCLIC, /*!< A cyclic event removed, no value. */
+    WETS_RECORD_REFUSED_EVENT, /*!< An event refused by its group, the value
+                                    is the error returned to the producer. */
+} WETS_RecordKind_t;
+
+/*!
+ * The sink of the records.
+ *
+ * \param[in] data: The header or the record.
+ * \param[in] size: The size in byte.
+ */
+typedef void (*pRecordSink)(const uint8_t* data, uint8_t size);
+
+/*!
+ * This function starts the recorder: the header is written immediately.
+ *
+ * \param[in] sink: The sink of the records.
+ */
+void WETS_startRecorder (pRecordSink sink);
+
+/*!
+ * This function stops the recorder.
+ */
+void WETS_stopRecorder (void);
+
+/*!
+ * This function writes a record, it is called by the scheduler.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in]     kind: The record kind.
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The event.
+ * \param[in]    value: The value, unused by the kinds without it.
+ */
+void WETS_record (WETS_RecordKind_t kind, uint8_t priority, uint32_t event, uint32_t value);
+
+/*!
+ * This function writes the record of a new cyclic event, it is called by
+ * the scheduler.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] priority: The priority group of the event.
+ * \param[in]    event: The event.
+ * \param[in]   period: The period in milli-second.
+ * \param[in]    phase: The time in milli-second of the first event.
+ */
+void WETS_recordCyclic (uint8_t priority, uint32_t event, uint32_t period, uint32_t phase);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_RECORD_H
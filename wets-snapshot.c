@@ -0,0 +1,380 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-snapshot.c
+ * \brief
+ */
+
+#include "wets-snapshot.h"
+#include "wets-event.h"
+#include "wets-delay.h"
+#include "wets-cyclic.h"
+
+#if (WETS_USE_SNAPSHOT == 1)
+
+#if (WETS_SNAPSHOT_BUILD_ID == 0)
+#error "WETS_USE_SNAPSHOT requires WETS_SNAPSHOT_BUILD_ID"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_Snapshot
+ * \{
+ */
+
+/*!
+ * The first bytes of a blob, "WSNP".
+ */
+#define WETS_SNAPSHOT_MAGIC                      0x504E5357ul
+
+/*!
+ * The version of the blob format.
+ */
+#define WETS_SNAPSHOT_VERSION                    1u
+
+/*!
+ * The size of the header: magic, version, pointer size, priority levels,
+ * payload flag, blob size, tick period, build, time base and the three
+ * counters followed by a reserved byte.
+ */
+#define WETS_SNAPSHOT_HEADER_SIZE                28u
+
+/*!
+ * The size of the CRC at the end of the blob.
+ */
+#define WETS_SNAPSHOT_CRC_SIZE                   4u
+
+/*!
+ * The size of a delayed timer: priority, event, callback and remaining time.
+ */
+#define WETS_SNAPSHOT_DELAY_SIZE                 13u
+
+/*!
+ * The size of a cyclic timer: a delayed timer followed by its period.
+ */
+#define WETS_SNAPSHOT_CYCLIC_SIZE                17u
+
+/*!
+ * The size of a pending event: priority, event, callback and the payload.
+ */
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+#define WETS_SNAPSHOT_EVENT_SIZE                 17u
+#else
+#define WETS_SNAPSHOT_EVENT_SIZE                 9u
+#endif
+
+/*!
+ * The timers and the events copied by the snapshot, in the same order of
+ * the blob: delayed timers, cyclic timers and pending events.
+ */
+static WETS_SnapshotEntry_t mEntries[WETS_MAX_SNAPSHOT_ENTRIES];
+
+/*!
+ * The function returns the identifier of the build.
+ */
+static uint32_t getBuild (void)
+{
+    return (uint32_t)WETS_SNAPSHOT_BUILD_ID;
+}
+
+/*!
+ * The function computes the CRC-32 (IEEE 802.3) of a buffer.
+ */
+static uint32_t getCrc (const uint8_t* data, uint32_t size)
+{
+    uint32_t crc = 0xFFFFFFFFul;
+
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; ++j)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320ul & (0ul - (crc & 1ul)));
+        }
+    }
+    return ~crc;
+}
+
+static void putU32 (uint8_t** data, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        *(*data)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t getU32 (const uint8_t** data)
+{
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        value |= (uint32_t)(*(*data)++) << (8 * i);
+    }
+    return value;
+}
+
+/*!
+ * The callbacks are stored as offset from \ref WETS_init, the blob can be
+ * restored also when the program is loaded at another address.
+ */
+static intptr_t getCallbackBase (void)
+{
+    return (intptr_t)&WETS_init;
+}
+
+/*!
+ * The function copies the timers and the pending events.
+ *
+ * \param[out]  delays: The number of delayed timers.
+ * \param[out] cyclics: The number of cyclic timers.
+ * \param[out]  events: The number of pending events.
+ * \return The size of the blob, 0 when the entries are too many.
+ */
+static uint32_t saveEntries (uint8_t* delays, uint8_t* cyclics, uint8_t* events)
+{
+    uint8_t count = 0;
+
+    *delays   = WETS_saveDelayEvents(&mEntries[count],WETS_MAX_SNAPSHOT_ENTRIES - count);
+    count    += *delays;
+    *cyclics  = WETS_saveCyclicEvents(&mEntries[count],WETS_MAX_SNAPSHOT_ENTRIES - count);
+    count    += *cyclics;
+    *events   = WETS_saveEvents(&mEntries[count],WETS_MAX_SNAPSHOT_ENTRIES - count);
+    count    += *events;
+
+    // A full table could hide other entries
+    if (count == WETS_MAX_SNAPSHOT_ENTRIES)
+    {
+        return 0;
+    }
+
+    return WETS_SNAPSHOT_HEADER_SIZE +
+           ((uint32_t)*delays  * WETS_SNAPSHOT_DELAY_SIZE) +
+           ((uint32_t)*cyclics * WETS_SNAPSHOT_CYCLIC_SIZE) +
+           ((uint32_t)*events  * WETS_SNAPSHOT_EVENT_SIZE) +
+           WETS_SNAPSHOT_CRC_SIZE;
+}
+
+uint32_t WETS_getSnapshotSize (void)
+{
+    uint8_t delays, cyclics, events;
+
+    return saveEntries(&delays,&cyclics,&events);
+}
+
+uint32_t WETS_snapshot (void* buffer, uint32_t size)
+{
+    uint8_t delays, cyclics, events;
+    uint8_t* data = (uint8_t*)buffer;
+
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    uint32_t time  = WETS_getCurrentTime();
+    uint32_t total = saveEntries(&delays,&cyclics,&events);
+    if ((total == 0) || (total > size))
+    {
+        return 0;
+    }
+
+    putU32(&data,WETS_SNAPSHOT_MAGIC);
+    *data++ = WETS_SNAPSHOT_VERSION;
+    *data++ = (uint8_t)sizeof(void*);
+    *data++ = WETS_MAX_PRIORITY_LEVEL;
+    *data++ = WETS_USE_EVENT_PAYLOAD;
+    putU32(&data,total);
+    putU32(&data,WETS_ISR_PERIOD_ms);
+    putU32(&data,getBuild());
+    putU32(&data,time);
+    *data++ = delays;
+    *data++ = cyclics;
+    *data++ = events;
+    *data++ = 0;
+
+    for (uint8_t i = 0; i < (delays + cyclics + events); ++i)
+    {
+        intptr_t offset = (intptr_t)mEntries[i].cb - getCallbackBase();
+        if ((offset < INT32_MIN) || (offset > INT32_MAX))
+        {
+            return 0;
+        }
+
+        *data++ = mEntries[i].priority;
+        putU32(&data,mEntries[i].event);
+        putU32(&data,(uint32_t)(int32_t)offset);
+
+        if (i < (delays + cyclics))
+        {
+            putU32(&data,mEntries[i].remaining);
+        }
+        if ((i >= delays) && (i < (delays + cyclics)))
+        {
+            putU32(&data,mEntries[i].period);
+        }
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+        if (i >= (delays + cyclics))
+        {
+            putU32(&data,(uint32_t)mEntries[i].payload);
+            putU32(&data,(uint32_t)((uint64_t)mEntries[i].payload >> 32));
+        }
+#endif
+    }
+
+    putU32(&data,getCrc((const uint8_t*)buffer,total - WETS_SNAPSHOT_CRC_SIZE));
+    return total;
+}
+
+WETS_Error_t WETS_restore (const void* buffer, uint32_t size, uint32_t elapsed)
+{
+    const uint8_t* data = (const uint8_t*)buffer;
+    WETS_Error_t result = WETS_ERROR_SUCCESS;
+
+    if ((buffer == NULL) ||
+        (size < (WETS_SNAPSHOT_HEADER_SIZE + WETS_SNAPSHOT_CRC_SIZE)) ||
+        (getU32(&data) != WETS_SNAPSHOT_MAGIC))
+    {
+        return WETS_ERROR_SNAPSHOT_INVALID;
+    }
+
+    const uint8_t* crc = (const uint8_t*)buffer + size - WETS_SNAPSHOT_CRC_SIZE;
+    if (getU32(&crc) != getCrc((const uint8_t*)buffer,size - WETS_SNAPSHOT_CRC_SIZE))
+    {
+        return WETS_ERROR_SNAPSHOT_INVALID;
+    }
+
+    uint8_t version  = *data++;
+    uint8_t pointer  = *data++;
+    uint8_t levels   = *data++;
+    uint8_t payload  = *data++;
+    uint32_t total   = getU32(&data);
+    uint32_t period  = getU32(&data);
+    uint32_t build   = getU32(&data);
+    uint32_t time    = getU32(&data);
+    uint8_t delays   = *data++;
+    uint8_t cyclics  = *data++;
+    uint8_t events   = *data++;
+    data++;
+
+    if ((version != WETS_SNAPSHOT_VERSION) ||
+        (pointer != sizeof(void*))         ||
+        (levels  != WETS_MAX_PRIORITY_LEVEL) ||
+        (payload != WETS_USE_EVENT_PAYLOAD) ||
+        (period  != WETS_ISR_PERIOD_ms)    ||
+        (build   != getBuild()))
+    {
+        return WETS_ERROR_SNAPSHOT_MISMATCH;
+    }
+
+    if ((total != size) ||
+        (total != (WETS_SNAPSHOT_HEADER_SIZE +
+                   ((uint32_t)delays  * WETS_SNAPSHOT_DELAY_SIZE) +
+                   ((uint32_t)cyclics * WETS_SNAPSHOT_CYCLIC_SIZE) +
+                   ((uint32_t)events  * WETS_SNAPSHOT_EVENT_SIZE) +
+                   WETS_SNAPSHOT_CRC_SIZE)))
+    {
+        return WETS_ERROR_SNAPSHOT_INVALID;
+    }
+
+    WETS_restoreCurrentTime(time + elapsed);
+
+    // Timers before the pending events, adding a timer clears its event
+    for (uint16_t i = 0; i < ((uint16_t)delays + cyclics + events); ++i)
+    {
+        WETS_SnapshotEntry_t entry;
+        WETS_Error_t err = WETS_ERROR_SUCCESS;
+        uint32_t saved = 0;
+        bool expired = FALSE;
+
+        entry.priority = *data++;
+        entry.event    = getU32(&data);
+        entry.cb       = (pEventCallback)(getCallbackBase() + (int32_t)getU32(&data));
+        entry.payload  = 0;
+        entry.period   = 0;
+
+        if (i < ((uint16_t)delays + cyclics))
+        {
+            saved = getU32(&data);
+            expired = (saved <= elapsed);
+            entry.remaining = expired ? 0 : (saved - elapsed);
+        }
+
+        if (i < delays)
+        {
+            err = expired ? WETS_addEvent(entry.cb,entry.priority,entry.event) :
+                            WETS_addDelayEvent(entry.cb,entry.priority,entry.event,entry.remaining);
+        }
+        else if (i < ((uint16_t)delays + cyclics))
+        {
+            entry.period = getU32(&data);
+            if (expired && (entry.period > 0))
+            {
+                // Keep the phase of the missed cycles
+                entry.remaining = entry.period - ((elapsed - saved) % entry.period);
+            }
+            err = WETS_restoreCyclicEvent(&entry);
+            if (expired && (err == WETS_ERROR_SUCCESS))
+            {
+                err = WETS_addEvent(entry.cb,entry.priority,entry.event);
+            }
+        }
+        else
+        {
+#if (WETS_USE_EVENT_PAYLOAD == 1)
+            entry.payload  = (uintptr_t)getU32(&data);
+            entry.payload |= (uintptr_t)((uint64_t)getU32(&data) << 32);
+            err = WETS_addPayloadEvent(entry.cb,entry.priority,entry.event,entry.payload);
+#else
+            err = WETS_addEvent(entry.cb,entry.priority,entry.event);
+#endif
+        }
+
+        // An event can be already pending because of an expired timer
+        if ((err != WETS_ERROR_SUCCESS) && (err != WETS_ERROR_EVENT_JUST_SET) &&
+            (result == WETS_ERROR_SUCCESS))
+        {
+            result = err;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_SNAPSHOT
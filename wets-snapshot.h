@@ -0,0 +1,132 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-snapshot.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_SNAPSHOT_H
+#define __WARCOMEB_WETS_SNAPSHOT_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_Snapshot WETS Snapshot Management
+ * \ingroup  WETS
+ * \{
+ *
+ * A snapshot copies the pending events, the delayed timers, the cyclic
+ * timers and the time base into a binary blob. After a power-down or a
+ * restart, \ref WETS_restore puts them back in a single pass, with the
+ * deadlines moved by the elapsed time and the phases of the cyclic timers
+ * kept, instead of adding again each event with the public functions.
+ *
+ * The blob starts with a header (magic, version, size, configuration and
+ * build identifier) and ends with a CRC-32. The callbacks are stored as
+ * offsets from \ref WETS_init, so the blob is valid only for the same build,
+ * but also when the program is loaded at another address.
+ *
+ * The payloads of the pending events, see \ref WETS_addPayloadEvent, are
+ * stored as raw values: they must be plain values, like a counter, an index
+ * or an identifier. A payload that is a pointer is restored with the same
+ * address, whose content is lost with the power-down, and it is not moved
+ * like the callbacks when the program is loaded at another address.
+ *
+ * \note The snapshot must be done when no event is dispatched, and the
+ *       restore just after \ref WETS_init.
+ */
+
+/*!
+ * The maximum number of timers and pending events in a snapshot.
+ */
+#if !defined (WETS_MAX_SNAPSHOT_ENTRIES)
+#define WETS_MAX_SNAPSHOT_ENTRIES                48u
+#endif
+
+/*!
+ * The identifier of the build, a blob of another build is refused. It must
+ * be given by the build of the firmware, and it must change with each
+ * image, for example a hash of the sources or a build counter: the time of
+ * compilation of this module doesn't change when only the other modules,
+ * and so the offsets of the callbacks, are changed.
+ */
+#if !defined (WETS_SNAPSHOT_BUILD_ID)
+#define WETS_SNAPSHOT_BUILD_ID                   0u
+#endif
+
+/*!
+ * This function returns the size of the blob for the current events and
+ * timers.
+ *
+ * \return The size in byte, 0 when they are more than
+ *         \ref WETS_MAX_SNAPSHOT_ENTRIES.
+ */
+uint32_t WETS_getSnapshotSize (void);
+
+/*!
+ * This function copies the events, the timers and the time base into the
+ * buffer.
+ *
+ * \param[out] buffer: The buffer for the blob.
+ * \param[in]    size: The size of the buffer in byte.
+ * \return The size of the blob in byte, 0 when the buffer is too small, the
+ *         events are too many or a callback can't be stored.
+ */
+uint32_t WETS_snapshot (void* buffer, uint32_t size);
+
+/*!
+ * This function validates a blob and restores the events and the timers.
+ * The time base is moved forward by the elapsed time: the expired delayed
+ * events are posted, and the expired cyclic events are posted once and
+ * rescheduled with their phase.
+ *
+ * \param[in]  buffer: The blob.
+ * \param[in]    size: The size of the blob in byte.
+ * \param[in] elapsed: The time in milli-second elapsed since the snapshot.
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SNAPSHOT_INVALID when the blob is damaged
+ *         \arg \ref WETS_ERROR_SNAPSHOT_MISMATCH when the blob was made by
+ *              another version, configuration or build
+ *         \arg the error of the first event or timer not restored
+ *         \arg \ref WETS_ERROR_SUCCESS otherwise
+ */
+WETS_Error_t WETS_restore (const void* buffer, uint32_t size, uint32_t elapsed);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_SNAPSHOT_H
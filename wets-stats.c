@@ -0,0 +1,212 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-stats.c
+ * \brief
+ */
+
+#include "wets-stats.h"
+#include "wets-event.h"
+
+#if (WETS_USE_STATISTICS == 1)
+
+#if (WETS_USE_STATISTICS_SHM == 1)
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_Statistics
+ * \{
+ */
+
+#if (WETS_STATISTICS_USE_ATOMIC == 1) && defined (__GNUC__)
+#define WETS_STATISTICS_ADD(x,n)                 __atomic_fetch_add(&(x),(n),__ATOMIC_RELAXED)
+#else
+#define WETS_STATISTICS_ADD(x,n)                 ((x) += (n))
+#endif
+
+/*!
+ * The private statistics block.
+ */
+static WETS_Statistics_t mPrivateStatistics =
+{
+    .magic      = WETS_STATISTICS_MAGIC,
+    .version    = WETS_STATISTICS_VERSION,
+    .priorities = WETS_MAX_PRIORITY_LEVEL,
+};
+
+/*!
+ * The current statistics block, private or shared.
+ */
+static WETS_Statistics_t* mStatistics = &mPrivateStatistics;
+
+#if (WETS_USE_STATISTICS_SHM == 1)
+/*!
+ * The name of the published shared memory object.
+ */
+static char mSharedName[64];
+#endif
+
+void WETS_countStatistic (uint8_t priority, WETS_Counter_t counter)
+{
+    WETS_STATISTICS_ADD(mStatistics->counter[priority][counter],1u);
+}
+
+void WETS_addStatisticTime (uint32_t idle, uint32_t busy)
+{
+    if (idle > 0)
+    {
+        WETS_STATISTICS_ADD(mStatistics->idleTime,idle);
+    }
+    if (busy > 0)
+    {
+        WETS_STATISTICS_ADD(mStatistics->busyTime,busy);
+    }
+}
+
+void WETS_countWakeup (WETS_Wakeup_t cause)
+{
+    WETS_STATISTICS_ADD(mStatistics->wakeup[cause],1u);
+}
+
+uint32_t WETS_getSpuriousWakeups (void)
+{
+    return mStatistics->wakeup[WETS_WAKEUP_TICK] + mStatistics->wakeup[WETS_WAKEUP_UNKNOWN];
+}
+
+uint16_t WETS_getDutyCycle (void)
+{
+    uint32_t idle  = mStatistics->idleTime;
+    uint32_t total = WETS_getCurrentTime() - mStatistics->startTime;
+
+    if ((total == 0) || (idle >= total))
+    {
+        return 0;
+    }
+    return (uint16_t)(((uint64_t)(total - idle) * 1000u) / total);
+}
+
+const WETS_Statistics_t* WETS_getStatistics (void)
+{
+    return mStatistics;
+}
+
+void WETS_clearStatistics (void)
+{
+    mStatistics->startTime = WETS_getCurrentTime();
+    mStatistics->idleTime  = 0;
+    mStatistics->busyTime  = 0;
+
+    for (uint8_t i = 0; i < WETS_WAKEUP_NUMBER; ++i)
+    {
+        mStatistics->wakeup[i] = 0;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        for (uint8_t j = 0; j < WETS_COUNTER_NUMBER; ++j)
+        {
+            mStatistics->counter[i][j] = 0;
+        }
+    }
+}
+
+#if (WETS_USE_STATISTICS_SHM == 1)
+WETS_Error_t WETS_publishStatistics (const char* name)
+{
+    if (ohiassert((name != NULL) && (strlen(name) < sizeof(mSharedName))) != ERRORS_NO_ERROR)
+    {
+        return WETS_ERROR_WRONG_PARAMS;
+    }
+
+    if (mStatistics != &mPrivateStatistics)
+    {
+        WETS_unpublishStatistics();
+    }
+
+    int fd = shm_open(name,O_CREAT | O_RDWR,0644);
+    if (fd < 0)
+    {
+        return WETS_ERROR_SHARED_MEMORY;
+    }
+
+    if (ftruncate(fd,sizeof(WETS_Statistics_t)) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return WETS_ERROR_SHARED_MEMORY;
+    }
+
+    void* page = mmap(NULL,sizeof(WETS_Statistics_t),PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    // The mapping remains valid without the descriptor
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return WETS_ERROR_SHARED_MEMORY;
+    }
+
+    memcpy(page,&mPrivateStatistics,sizeof(WETS_Statistics_t));
+    strcpy(mSharedName,name);
+    mStatistics = (WETS_Statistics_t*)page;
+
+    return WETS_ERROR_SUCCESS;
+}
+
+void WETS_unpublishStatistics (void)
+{
+    if (mStatistics != &mPrivateStatistics)
+    {
+        WETS_Statistics_t* page = mStatistics;
+
+        memcpy(&mPrivateStatistics,page,sizeof(WETS_Statistics_t));
+        mStatistics = &mPrivateStatistics;
+
+        munmap(page,sizeof(WETS_Statistics_t));
+        shm_unlink(mSharedName);
+        mSharedName[0] = '\0';
+    }
+}
+#endif
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_STATISTICS
@@ -0,0 +1,227 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-stats.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_STATS_H
+#define __WARCOMEB_WETS_STATS_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_Statistics WETS Statistics Management
+ * \ingroup  WETS
+ * \{
+ *
+ * The scheduler counts, for each priority, the posted, dispatched, dropped
+ * and merged events and the timer expiries, the time spent idle and busy,
+ * and the wake-ups of the idle path with their cause. The counters are
+ * relaxed: they are updated without locks, a reader can see a block where
+ * the counters are not updated at the same instant.
+ * On POSIX hosts the block can be moved into a shared memory page, so an
+ * external monitor reads the live counters without any system call on the
+ * scheduler side.
+ */
+
+#if !defined (WETS_STATISTICS_USE_ATOMIC)
+#define WETS_STATISTICS_USE_ATOMIC               1u
+#endif
+
+/*!
+ * The identifier of the statistics block, "WETS" in ASCII.
+ */
+#define WETS_STATISTICS_MAGIC                    0x57455453ul
+
+/*!
+ * The version of the statistics block layout.
+ */
+#define WETS_STATISTICS_VERSION                  2u
+
+/*!
+ * List of all counters of a priority.
+ */
+typedef enum _WETS_Counter
+{
+    WETS_COUNTER_POSTED = 0,
+    WETS_COUNTER_DISPATCHED,
+    WETS_COUNTER_DROPPED,
+    WETS_COUNTER_MERGED,
+    WETS_COUNTER_EXPIRED,
+
+    WETS_COUNTER_NUMBER,
+} WETS_Counter_t;
+
+/*!
+ * List of all causes of a wake-up of the idle path. The wake-ups caused by
+ * \ref WETS_WAKEUP_TICK and \ref WETS_WAKEUP_UNKNOWN are spurious: the core
+ * woke-up without work to do.
+ */
+typedef enum _WETS_Wakeup
+{
+    /*!< A tick made a timer expire. */
+    WETS_WAKEUP_TIMER = 0,
+    /*!< A tick without any timer expiry. */
+    WETS_WAKEUP_TICK,
+    /*!< An event set by an interrupt. */
+    WETS_WAKEUP_EVENT,
+    /*!< An event posted by another thread. */
+    WETS_WAKEUP_POSTED,
+    /*!< A ready file descriptor. */
+    WETS_WAKEUP_IO,
+    /*!< Neither a tick nor an event. */
+    WETS_WAKEUP_UNKNOWN,
+
+    WETS_WAKEUP_NUMBER,
+} WETS_Wakeup_t;
+
+/*!
+ * The statistics block.
+ */
+typedef struct _WETS_Statistics
+{
+    /*!< It is \ref WETS_STATISTICS_MAGIC. */
+    uint32_t magic;
+
+    /*!< It is \ref WETS_STATISTICS_VERSION. */
+    uint32_t version;
+
+    /*!< The number of priority groups. */
+    uint32_t priorities;
+
+    /*!< The time when the counters were cleared. */
+    volatile uint32_t startTime;
+
+    /*!< The time, in milli-second, spent waiting for events. */
+    volatile uint32_t idleTime;
+
+    /*!< The time, in milli-second, spent into the callbacks. */
+    volatile uint32_t busyTime;
+
+    /*!< The counters of each priority, indexed by \ref WETS_Counter_t. */
+    volatile uint32_t counter[WETS_MAX_PRIORITY_LEVEL][WETS_COUNTER_NUMBER];
+
+    /*!< The wake-ups of the idle path, indexed by \ref WETS_Wakeup_t. */
+    volatile uint32_t wakeup[WETS_WAKEUP_NUMBER];
+
+} WETS_Statistics_t;
+
+/*!
+ * This function increments a counter of a priority group.
+ *
+ * \note It is called by the scheduler, it not must be called in other cases.
+ *
+ * \param[in] priority: The priority group.
+ * \param[in]  counter: The counter to be incremented.
+ */
+void WETS_countStatistic (uint8_t priority, WETS_Counter_t counter);
+
+/*!
+ * This function adds the idle and busy time.
+ *
+ * \note It is called by the scheduler, it not must be called in other cases.
+ *
+ * \param[in] idle: The idle time to add in milli-second.
+ * \param[in] busy: The busy time to add in milli-second.
+ */
+void WETS_addStatisticTime (uint32_t idle, uint32_t busy);
+
+/*!
+ * This function counts a wake-up of the idle path.
+ *
+ * \note It is called by the scheduler, it not must be called in other cases.
+ *
+ * \param[in] cause: The cause of the wake-up.
+ */
+void WETS_countWakeup (WETS_Wakeup_t cause);
+
+/*!
+ * This function returns the number of wake-ups without work to do.
+ *
+ * \return The number of spurious wake-ups.
+ */
+uint32_t WETS_getSpuriousWakeups (void);
+
+/*!
+ * This function returns the duty cycle of the core: the time out of the
+ * idle path over the total time since the counters were cleared.
+ *
+ * \return The duty cycle in tenths of percent (0..1000).
+ */
+uint16_t WETS_getDutyCycle (void);
+
+/*!
+ * This function returns the statistics block.
+ *
+ * \return The pointer to the current block.
+ */
+const WETS_Statistics_t* WETS_getStatistics (void);
+
+/*!
+ * This function clear all counters.
+ */
+void WETS_clearStatistics (void);
+
+#if (WETS_USE_STATISTICS_SHM == 1)
+/*!
+ * This function moves the statistics block into a POSIX shared memory
+ * object, that an external monitor can open and map read-only.
+ * The counters are copied, the scheduler then writes directly into the
+ * shared page.
+ *
+ * \param[in] name: The name of the shared memory object, like "/wets".
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the block was published.
+ *         \arg \ref WETS_ERROR_SHARED_MEMORY when the object can't be
+ *                   created or mapped.
+ *         \arg \ref WETS_ERROR_WRONG_PARAMS when the function parameters
+ *                   is not valid.
+ */
+WETS_Error_t WETS_publishStatistics (const char* name);
+
+/*!
+ * This function moves the statistics block back into the private memory,
+ * and removes the shared memory object.
+ */
+void WETS_unpublishStatistics (void);
+#endif
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_STATS_H
@@ -0,0 +1,289 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-thread.c
+ * \brief
+ */
+
+#include "wets-thread.h"
+#include "wets-event.h"
+#include "wets-delay.h"
+#include "wets-cyclic.h"
+
+#if (WETS_USE_PRIORITY_THREADS == 1)
+
+#if (WETS_USE_CRITICAL_SECTION != 1)
+#error "WETS_USE_PRIORITY_THREADS requires WETS_USE_CRITICAL_SECTION"
+#endif
+
+// The aging and the drain mode are policies of the single loop, the group
+// threads dispatch their own priority
+#if (WETS_USE_AGING == 1)
+#error "WETS_USE_AGING can't be used with WETS_USE_PRIORITY_THREADS"
+#endif
+#if (WETS_USE_DRAIN_MODE == 1)
+#error "WETS_USE_DRAIN_MODE can't be used with WETS_USE_PRIORITY_THREADS"
+#endif
+
+// The tables of the links and of the state machines are not locked, and
+// they are changed by the callbacks of every group
+#if (WETS_USE_EVENT_CHAIN == 1)
+#error "WETS_USE_EVENT_CHAIN can't be used with WETS_USE_PRIORITY_THREADS"
+#endif
+#if (WETS_USE_STATE_MACHINE == 1)
+#error "WETS_USE_STATE_MACHINE can't be used with WETS_USE_PRIORITY_THREADS"
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \ingroup  WETS_PriorityThread
+ * \{
+ */
+
+/*!
+ * The lock of the scheduler tables.
+ */
+static pthread_mutex_t mLock;
+
+static pthread_once_t mLockOnce = PTHREAD_ONCE_INIT;
+
+/*!
+ * The semaphore of each group, posted when an event is added.
+ */
+static sem_t mReady[WETS_MAX_PRIORITY_LEVEL];
+
+static pthread_t mThreads[WETS_MAX_PRIORITY_LEVEL];
+
+static pthread_t mTick;
+
+/*!
+ * Whether the threads are running.
+ */
+static atomic_bool mRunning = FALSE;
+
+/*!
+ * Create the recursive mutex with priority inheritance, it is called once
+ * at the first critical section.
+ */
+static void openLock (void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutexattr_setprotocol(&attr,PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&mLock,&attr);
+    pthread_mutexattr_destroy(&attr);
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        sem_init(&mReady[i],0,0);
+    }
+}
+
+void WETS_lockPriorityThreads (void)
+{
+    pthread_once(&mLockOnce,openLock);
+    pthread_mutex_lock(&mLock);
+}
+
+void WETS_unlockPriorityThreads (void)
+{
+    pthread_mutex_unlock(&mLock);
+}
+
+/*!
+ * The body of the group threads: it waits an event of its group, then it
+ * dispatches the ready events from the most important.
+ */
+static void* dispatcher (void* arg)
+{
+    uint8_t priority = (uint8_t)(uintptr_t)arg;
+
+    while (atomic_load(&mRunning))
+    {
+        while ((sem_wait(&mReady[priority]) != 0) && (errno == EINTR))
+        {
+            // Wait again
+        }
+
+        while (atomic_load(&mRunning) && WETS_dispatchPriorityEvent(priority))
+        {
+            // Dispatch the next one
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * The body of the tick thread: it advances the time base on absolute
+ * deadlines, so the ticks don't drift, and updates the timers.
+ */
+static void* ticker (void* unused)
+{
+    struct timespec next;
+    (void)unused;
+
+    clock_gettime(CLOCK_MONOTONIC,&next);
+    while (atomic_load(&mRunning))
+    {
+        next.tv_nsec += (long)WETS_ISR_PERIOD_ms * 1000000l;
+        if (next.tv_nsec >= 1000000000l)
+        {
+            next.tv_nsec -= 1000000000l;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&next,NULL);
+
+        WETS_timerIsrCallback(NULL);
+        WETS_updateDelayEvents();
+        WETS_updateCyclicEvents();
+    }
+    return NULL;
+}
+
+/*!
+ * The function creates a thread with a SCHED_FIFO priority, or with the
+ * default policy when the real-time priorities are not allowed.
+ *
+ * \param[out]   thread: The thread.
+ * \param[in]      body: The body of the thread.
+ * \param[in]       arg: The argument of the body.
+ * \param[in]  priority: The SCHED_FIFO priority.
+ * \param[out] realTime: Cleared when the default policy was used.
+ * \return TRUE when the thread was created, FALSE otherwise.
+ */
+static bool createThread (pthread_t* thread,
+                          void* (*body)(void*),
+                          void* arg,
+                          int priority,
+                          bool* realTime)
+{
+    pthread_attr_t attr;
+    struct sched_param param = { .sched_priority = priority };
+    int result;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr,PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr,SCHED_FIFO);
+    pthread_attr_setschedparam(&attr,&param);
+    result = pthread_create(thread,&attr,body,arg);
+    pthread_attr_destroy(&attr);
+
+    if (result == EPERM)
+    {
+        *realTime = FALSE;
+        result = pthread_create(thread,NULL,body,arg);
+    }
+    return (result == 0);
+}
+
+/*!
+ * The function stops the first group threads.
+ *
+ * \param[in] count: The number of group threads to be stopped.
+ */
+static void joinThreads (uint8_t count)
+{
+    atomic_store(&mRunning,FALSE);
+
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        sem_post(&mReady[i]);
+        pthread_join(mThreads[i],NULL);
+    }
+}
+
+WETS_Error_t WETS_startPriorityThreads (void)
+{
+    bool realTime = TRUE;
+
+    pthread_once(&mLockOnce,openLock);
+
+    if (atomic_exchange(&mRunning,TRUE))
+    {
+        return WETS_ERROR_THREAD_FAILED;
+    }
+
+    for (uint8_t i = 0; i < WETS_MAX_PRIORITY_LEVEL; ++i)
+    {
+        int priority = WETS_THREAD_BASE_PRIORITY + (int)(WETS_MAX_PRIORITY_LEVEL - 1u - i);
+        if (!createThread(&mThreads[i],dispatcher,(void*)(uintptr_t)i,priority,&realTime))
+        {
+            joinThreads(i);
+            return WETS_ERROR_THREAD_FAILED;
+        }
+        // The events added before the start
+        sem_post(&mReady[i]);
+    }
+
+    if (!createThread(&mTick,ticker,NULL,WETS_THREAD_BASE_PRIORITY + WETS_MAX_PRIORITY_LEVEL,&realTime))
+    {
+        joinThreads(WETS_MAX_PRIORITY_LEVEL);
+        return WETS_ERROR_THREAD_FAILED;
+    }
+
+    return realTime ? WETS_ERROR_SUCCESS : WETS_ERROR_NO_REAL_TIME;
+}
+
+void WETS_stopPriorityThreads (void)
+{
+    if (!atomic_load(&mRunning))
+    {
+        return;
+    }
+
+    joinThreads(WETS_MAX_PRIORITY_LEVEL);
+    pthread_join(mTick,NULL);
+}
+
+void WETS_notifyPriorityThread (uint8_t priority)
+{
+    pthread_once(&mLockOnce,openLock);
+    sem_post(&mReady[priority]);
+}
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WETS_USE_PRIORITY_THREADS
@@ -0,0 +1,115 @@
+/*
+ * WETS - Warcomeb Easy Task Scheduler
+ * Copyright (C) 2019 Marco Giammarini <http://www.warcomeb.it>
+ *
+ * Authors:
+ *  Marco Giammarini <m.giammarini@warcomeb.it>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file  /wets-thread.h
+ * \brief
+ */
+
+#ifndef __WARCOMEB_WETS_THREAD_H
+#define __WARCOMEB_WETS_THREAD_H
+
+#include "wets-types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+ * \defgroup WETS_PriorityThread WETS Priority Threads Management
+ * \ingroup  WETS
+ * \{
+ *
+ * The preemptive mode of the POSIX port: each priority group is dispatched
+ * by its own thread, with a SCHED_FIFO priority that is higher for the more
+ * important groups, so that an event of priority 0 preempts a long callback
+ * of priority 3 instead of waiting for its end. The tick is generated by a
+ * thread with the highest priority, that updates the delayed and cyclic
+ * events, and it replaces the timer interrupt and \ref WETS_loop().
+ *
+ * The critical sections of the scheduler become a recursive mutex with
+ * priority inheritance, so a low priority thread that holds the tables is
+ * raised to the priority of the threads waiting for them.
+ *
+ * \note The callbacks of a group run one at a time, but concurrently with
+ *       the callbacks of the other groups.
+ * \note The aging and the CPU budgets are not applied by the threads. The
+ *       aging, the drain mode, the event chains and the state machines
+ *       can't be enabled with the threads.
+ */
+
+/*!
+ * The SCHED_FIFO priority of the least important group, the group i takes
+ * WETS_THREAD_BASE_PRIORITY + WETS_MAX_PRIORITY_LEVEL - 1 - i, the tick
+ * thread the next one.
+ */
+#if !defined (WETS_THREAD_BASE_PRIORITY)
+#define WETS_THREAD_BASE_PRIORITY                10
+#endif
+
+/*!
+ * This function starts the tick thread and a thread for each priority
+ * group.
+ *
+ * \return The function returns:
+ *         \arg \ref WETS_ERROR_SUCCESS when the threads were started with
+ *                   their real-time priorities.
+ *         \arg \ref WETS_ERROR_NO_REAL_TIME when the process can't use
+ *                   SCHED_FIFO (CAP_SYS_NICE or RLIMIT_RTPRIO): the threads
+ *                   were started with the default policy, without
+ *                   preemption between the groups.
+ *         \arg \ref WETS_ERROR_THREAD_FAILED when a thread can't be created,
+ *                   or the threads are already running.
+ */
+WETS_Error_t WETS_startPriorityThreads (void);
+
+/*!
+ * This function stops the threads, after the end of the running callbacks.
+ *
+ * \note It must not be called from a callback.
+ */
+void WETS_stopPriorityThreads (void);
+
+/*!
+ * This function wakes up the thread of a priority group. It is called by the
+ * scheduler each time an event is added.
+ *
+ * \note It not must be called in other cases.
+ *
+ * \param[in] priority: The priority group.
+ */
+void WETS_notifyPriorityThread (uint8_t priority);
+
+/*!
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WARCOMEB_WETS_THREAD_H
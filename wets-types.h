@@ -82,6 +82,222 @@ static const Utility_Version_t WARCOMEB_WETS_LIBRARY_VERSION =
 #define WETS_USE_CRITICAL_SECTION                1u
 #endif
 
+/*!
+ * Store the timeouts of the timers on 16 bits instead of 32 bits. The
+ * timer tables are smaller, but a timeout can't be longer than 32767 ms.
+ */
+#if !defined (WETS_USE_16BIT_TIME)
+#define WETS_USE_16BIT_TIME                      0u
+#endif
+
+/*!
+ * Enable the profiling hooks of the scheduler, see \ref WETS_Profile.
+ */
+#if !defined (WETS_USE_PROFILING)
+#define WETS_USE_PROFILING                       0u
+#endif
+
+/*!
+ * Enable the drain mode: the scheduler dispatches all the ready events of a
+ * priority in one pass, with a single snapshot of the pending events,
+ * instead of one event for each scan. A higher priority event still stops
+ * the pass between two callbacks.
+ */
+#if !defined (WETS_USE_DRAIN_MODE)
+#define WETS_USE_DRAIN_MODE                      0u
+#endif
+
+/*!
+ * Enable the lock-free queue used to post events from other threads.
+ * It requires C11 atomics, see \ref WETS_PostEvent.
+ */
+#if !defined (WETS_USE_POST_QUEUE)
+#define WETS_USE_POST_QUEUE                      0u
+#endif
+
+/*!
+ * Enable the worker-thread pool used to run long callbacks outside the
+ * scheduler loop (POSIX only), see \ref WETS_OffloadEvent.
+ * It requires \ref WETS_USE_POST_QUEUE.
+ */
+#if !defined (WETS_USE_OFFLOAD)
+#define WETS_USE_OFFLOAD                         0u
+#endif
+
+/*!
+ * Enable the recorder of the posted events and of the timers, that can be
+ * replayed on the host, see \ref WETS_Recorder.
+ */
+#if !defined (WETS_USE_RECORDER)
+#define WETS_USE_RECORDER                        0u
+#endif
+
+/*!
+ * Enable the snapshot of the events and of the timers into a binary blob,
+ * used to restore the scheduler after a restart, see \ref WETS_Snapshot.
+ */
+#if !defined (WETS_USE_SNAPSHOT)
+#define WETS_USE_SNAPSHOT                        0u
+#endif
+
+/*!
+ * Enable the table-driven state machines, see \ref WETS_StateMachine.
+ */
+#if !defined (WETS_USE_STATE_MACHINE)
+#define WETS_USE_STATE_MACHINE                   0u
+#endif
+
+/*!
+ * Enable the event identifiers: arbitrary 32-bit values registered with
+ * their priority group and rank, see \ref WETS_EventId.
+ */
+#if !defined (WETS_USE_EVENT_ID)
+#define WETS_USE_EVENT_ID                        0u
+#endif
+
+/*!
+ * Enable the phase placement of the cyclic events: the first event of a
+ * timer is placed on the tick of its period where the fewest timers expire,
+ * the deadlines don't drift when an event is late, and the per-tick load is
+ * measured, see \ref WETS_addPhasedCyclicEvent.
+ */
+#if !defined (WETS_USE_CYCLIC_PHASE)
+#define WETS_USE_CYCLIC_PHASE                    0u
+#endif
+
+/*!
+ * Enable the cyclic executive: the callbacks of the cyclic events are
+ * called from a frame table built once over the hyperperiod, see
+ * \ref WETS_startCyclicExecutive.
+ */
+#if !defined (WETS_USE_CYCLIC_EXECUTIVE)
+#define WETS_USE_CYCLIC_EXECUTIVE                0u
+#endif
+
+/*!
+ * Enable the declared dependencies between events, see
+ * \ref WETS_EventChain.
+ */
+#if !defined (WETS_USE_EVENT_CHAIN)
+#define WETS_USE_EVENT_CHAIN                     0u
+#endif
+
+/*!
+ * Enable the events that wait for any or all of a set of events, see
+ * \ref WETS_EventGroup.
+ */
+#if !defined (WETS_USE_EVENT_GROUP)
+#define WETS_USE_EVENT_GROUP                     0u
+#endif
+
+/*!
+ * Enable the aging of the pending events: an event that waits more than the
+ * threshold of its priority is dispatched before the events of the higher
+ * priorities, so that a busy priority can't starve the lower ones.
+ */
+#if !defined (WETS_USE_AGING)
+#define WETS_USE_AGING                           0u
+#endif
+
+/*!
+ * The default aging threshold, in milli-second, of each priority.
+ */
+#if !defined (WETS_AGING_THRESHOLD_ms)
+#define WETS_AGING_THRESHOLD_ms                  100u
+#endif
+
+/*!
+ * Enable the per-priority wait-time metrics of the dispatched events.
+ */
+#if !defined (WETS_USE_WAIT_STATISTICS)
+#define WETS_USE_WAIT_STATISTICS                 WETS_USE_AGING
+#endif
+
+/*!
+ * Enable the scheduler counters, see \ref WETS_Statistics.
+ */
+#if !defined (WETS_USE_STATISTICS)
+#define WETS_USE_STATISTICS                      0u
+#endif
+
+/*!
+ * Enable the publication of the scheduler counters into a POSIX shared
+ * memory object. It requires \ref WETS_USE_STATISTICS.
+ */
+#if !defined (WETS_USE_STATISTICS_SHM)
+#define WETS_USE_STATISTICS_SHM                  0u
+#endif
+
+/*!
+ * Enable the file-descriptor event sources of the Linux port, see
+ * \ref WETS_IoSource. The idle path of \ref WETS_loop() waits into
+ * epoll_wait() until a descriptor is ready or the next timer expires.
+ */
+#if !defined (WETS_USE_IO_SOURCES)
+#define WETS_USE_IO_SOURCES                      0u
+#endif
+
+/*!
+ * Enable the optional payload attached to each event.
+ */
+#if !defined (WETS_USE_EVENT_PAYLOAD)
+#define WETS_USE_EVENT_PAYLOAD                   WETS_USE_POST_QUEUE
+#endif
+
+/*!
+ * Enable the per-priority policies applied when the slots of a priority
+ * group are all used, see \ref WETS_Overload_t.
+ */
+#if !defined (WETS_USE_OVERLOAD_POLICY)
+#define WETS_USE_OVERLOAD_POLICY                 0u
+#endif
+
+/*!
+ * Enable the per-priority CPU budgets over a replenishment period, see
+ * \ref WETS_setPriorityBudget.
+ */
+#if !defined (WETS_USE_CPU_BUDGET)
+#define WETS_USE_CPU_BUDGET                      0u
+#endif
+
+/*!
+ * Enable the shared-memory event bus between the schedulers of different
+ * processes, see \ref WETS_IpcBus. It requires \ref WETS_USE_IO_SOURCES.
+ */
+#if !defined (WETS_USE_IPC)
+#define WETS_USE_IPC                             0u
+#endif
+
+/*!
+ * Enable the re-arm of a delayed event from its own callback, see
+ * \ref WETS_rearmDelayEvent.
+ */
+#if !defined (WETS_USE_DELAY_REARM)
+#define WETS_USE_DELAY_REARM                     0u
+#endif
+
+/*!
+ * Enable the preemptive mode of the POSIX port: each priority group is
+ * dispatched by its own real-time thread, see \ref WETS_PriorityThread.
+ */
+#if !defined (WETS_USE_PRIORITY_THREADS)
+#define WETS_USE_PRIORITY_THREADS                0u
+#endif
+
+/*!
+ * Align the state shared between threads to the cache lines, so that the
+ * producers of different priorities, the tick and the scheduler loop don't
+ * write into the same line. It is meant for threaded host builds, where the
+ * memory cost of the padding is not an issue.
+ */
+#if !defined (WETS_USE_CACHE_ALIGNMENT)
+#define WETS_USE_CACHE_ALIGNMENT                 0u
+#endif
+
+#if !defined (WETS_CACHE_LINE_SIZE)
+#define WETS_CACHE_LINE_SIZE                     64u
+#endif
+
 
 /*!
  * List of all possible errors.
@@ -95,9 +311,44 @@ typedef enum _WETS_Errors
     WETS_ERROR_NO_EVENT_FOUND     = 0x0200,
     WETS_ERROR_EVENT_BUFFER_FULL  = 0x0201,
     WETS_ERROR_EVENT_JUST_SET     = 0x0202,
+    WETS_ERROR_POST_QUEUE_FULL    = 0x0203,
+    WETS_ERROR_OFFLOAD_QUEUE_FULL = 0x0204,
+    WETS_ERROR_EVENT_RETRY        = 0x0205,
 
     WETS_ERROR_NO_TIMER_AVAILABLE = 0x0300,
     WETS_ERROR_NO_TIMER_FOUND     = 0x0301,
+    WETS_ERROR_NO_FRAME_AVAILABLE = 0x0302,
+
+    WETS_ERROR_NO_CHAIN_AVAILABLE = 0x0400,
+    WETS_ERROR_NO_CHAIN_FOUND     = 0x0401,
+
+    WETS_ERROR_SHARED_MEMORY      = 0x0500,
+
+    WETS_ERROR_NO_IO_AVAILABLE    = 0x0600,
+    WETS_ERROR_NO_IO_FOUND        = 0x0601,
+    WETS_ERROR_IO_FAILED          = 0x0602,
+
+    WETS_ERROR_IPC_FAILED         = 0x0700,
+    WETS_ERROR_IPC_QUEUE_FULL     = 0x0701,
+    WETS_ERROR_NO_IPC_AVAILABLE   = 0x0702,
+    WETS_ERROR_NO_IPC_FOUND       = 0x0703,
+
+    WETS_ERROR_NO_GROUP_AVAILABLE = 0x0800,
+    WETS_ERROR_NO_GROUP_FOUND     = 0x0801,
+
+    WETS_ERROR_NO_ID_AVAILABLE    = 0x0900,
+    WETS_ERROR_NO_ID_FOUND        = 0x0901,
+    WETS_ERROR_ID_USED            = 0x0902,
+
+    WETS_ERROR_THREAD_FAILED      = 0x0A00,
+    WETS_ERROR_NO_REAL_TIME       = 0x0A01,
+
+    WETS_ERROR_NO_FSM_AVAILABLE   = 0x0B00,
+    WETS_ERROR_NO_FSM_FOUND       = 0x0B01,
+    WETS_ERROR_FSM_EVENT_USED     = 0x0B02,
+
+    WETS_ERROR_SNAPSHOT_INVALID   = 0x0C00,
+    WETS_ERROR_SNAPSHOT_MISMATCH  = 0x0C01,
 } WETS_Error_t;
 
 /*!
@@ -107,6 +358,86 @@ typedef uint32_t (*pEventCallback)(uint32_t event);
 
 #define WETS_NO_EVENT                            0xFFFFFFFFul
 #define WETS_NO_PRIORITY                         0xFF
+#define WETS_NO_TIMER                            0xFFu
+#define WETS_NO_TIMEOUT                          0xFFFFFFFFul
+
+/*!
+ * Type used to store the timeouts into the timer tables.
+ */
+#if (WETS_USE_16BIT_TIME == 1)
+typedef uint16_t WETS_Time_t;
+typedef int16_t  WETS_TimeDiff_t;
+#define WETS_MAX_TIMEOUT_ms                      0x7FFFul
+#else
+typedef uint32_t WETS_Time_t;
+typedef int32_t  WETS_TimeDiff_t;
+#define WETS_MAX_TIMEOUT_ms                      0x7FFFFFFFul
+#endif
+
+/*!
+ * Whether the timeout is expired, the comparison is correct also when the
+ * time wraps around.
+ */
+#define WETS_IS_TIME_EXPIRED(now,timeout)        ((WETS_TimeDiff_t)((WETS_Time_t)((now) - (timeout))) >= 0)
+
+/*!
+ * Start a variable or a field on its own cache line, when
+ * \ref WETS_USE_CACHE_ALIGNMENT is enabled.
+ */
+#if (WETS_USE_CACHE_ALIGNMENT == 1)
+#define WETS_CACHE_ALIGNED                       __attribute__((aligned(WETS_CACHE_LINE_SIZE)))
+#else
+#define WETS_CACHE_ALIGNED
+#endif
+
+/*!
+ * A scalar alone on its cache line, when \ref WETS_USE_CACHE_ALIGNMENT is
+ * enabled: the alignment places its start, and the size of the aligned
+ * structure, rounded to the line, keeps the following statics out of it.
+ * The scalar is the field value.
+ */
+#define WETS_CACHE_PADDED(type)                  struct { type value; } WETS_CACHE_ALIGNED
+
+#if (WETS_USE_SNAPSHOT == 1)
+/*!
+ * A pending event or a timer copied by \ref WETS_snapshot.
+ */
+typedef struct _WETS_SnapshotEntry
+{
+    /*!< The callback of the event. */
+    pEventCallback cb;
+
+    /*!< The event. */
+    uint32_t event;
+
+    /*!< The time in milli-second until the deadline of a timer. */
+    uint32_t remaining;
+
+    /*!< The period in milli-second of a cyclic timer, 0 for the others. */
+    uint32_t period;
+
+    /*!< The payload of a pending event. */
+    uintptr_t payload;
+
+    /*!< The priority group of the event. */
+    uint8_t priority;
+
+} WETS_SnapshotEntry_t;
+#endif
+
+#if (WETS_USE_PRIORITY_THREADS == 1)
+/*!
+ * With the priority threads, the critical sections of the scheduler take a
+ * recursive mutex with priority inheritance, see \ref WETS_PriorityThread.
+ */
+void WETS_lockPriorityThreads (void);
+void WETS_unlockPriorityThreads (void);
+
+#undef  CRITICAL_SECTION_BEGIN
+#define CRITICAL_SECTION_BEGIN()                 WETS_lockPriorityThreads()
+#undef  CRITICAL_SECTION_END
+#define CRITICAL_SECTION_END()                   WETS_unlockPriorityThreads()
+#endif
 
 /*!
  * \}
@@ -66,6 +66,45 @@ extern "C"
 #include "wets-event.h"
 #include "wets-delay.h"
 #include "wets-cyclic.h"
+#if (WETS_USE_EVENT_ID == 1)
+#include "wets-id.h"
+#endif
+#if (WETS_USE_STATE_MACHINE == 1)
+#include "wets-fsm.h"
+#endif
+#if (WETS_USE_POST_QUEUE == 1)
+#include "wets-post.h"
+#endif
+#if (WETS_USE_OFFLOAD == 1)
+#include "wets-offload.h"
+#endif
+#if (WETS_USE_EVENT_CHAIN == 1)
+#include "wets-chain.h"
+#endif
+#if (WETS_USE_EVENT_GROUP == 1)
+#include "wets-group.h"
+#endif
+#if (WETS_USE_STATISTICS == 1)
+#include "wets-stats.h"
+#endif
+#if (WETS_USE_IO_SOURCES == 1)
+#include "wets-io.h"
+#endif
+#if (WETS_USE_IPC == 1)
+#include "wets-ipc.h"
+#endif
+#if (WETS_USE_RECORDER == 1)
+#include "wets-record.h"
+#endif
+#if (WETS_USE_SNAPSHOT == 1)
+#include "wets-snapshot.h"
+#endif
+#if (WETS_USE_PRIORITY_THREADS == 1)
+#include "wets-thread.h"
+#endif
+#if (WETS_USE_PROFILING == 1)
+#include "wets-profile.h"
+#endif
 
 /*!
  * \}